@@ -0,0 +1,89 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+
+
+
+/*
+ * Description:
+ * this file writes the channel table used by the EM components to a binary
+ * file, maps the file back and checks that both tables hold the same
+ * values. The file can then be selected for any EM simulation through the
+ * P1906EMChannelTableFile global value, e.g.,
+ *   --P1906EMChannelTableFile=em-channel-table.bin
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/p1906-em-channel-table.h"
+#include <cstring>
+#include <iostream>
+
+using namespace ns3;
+
+
+int main (int argc, char *argv[])
+{
+  std::string fileName = "em-channel-table.bin";
+
+  CommandLine cmd;
+  cmd.AddValue("fileName", "the binary channel table to write", fileName);
+  cmd.Parse(argc, argv);
+
+  Ptr<const P1906EMChannelTable> table = P1906EMChannelTable::GetDefault ();
+  if (!table->Write (fileName))
+    {
+      std::cout << "cannot write " << fileName << std::endl;
+      return 1;
+    }
+
+  Ptr<const P1906EMChannelTable> loaded = P1906EMChannelTable::Load (fileName);
+  if (loaded == 0)
+    {
+      std::cout << "cannot load " << fileName << std::endl;
+      return 1;
+    }
+
+  uint32_t nDistances = table->GetNDistances ();
+  uint32_t nBands = table->GetNBands ();
+  bool same = loaded->GetNDistances () == nDistances && loaded->GetNBands () == nBands &&
+    std::memcmp (loaded->GetDistances (), table->GetDistances (), nDistances * sizeof (double)) == 0 &&
+    std::memcmp (loaded->GetBandFrequencies (), table->GetBandFrequencies (), nBands * sizeof (double)) == 0;
+  for (uint32_t d = 0; same && d < nDistances; d++)
+    {
+      same = std::memcmp (loaded->GetPathLoss (d), table->GetPathLoss (d), nBands * sizeof (double)) == 0 &&
+        std::memcmp (loaded->GetPathLossGain (d), table->GetPathLossGain (d), nBands * sizeof (double)) == 0 &&
+        std::memcmp (loaded->GetMolecularNoise (d), table->GetMolecularNoise (d), nBands * sizeof (double)) == 0;
+    }
+
+  std::cout << "table file           : " << fileName << std::endl;
+  std::cout << "[distances,bands]    : " << nDistances << " " << nBands << std::endl;
+  std::cout << "distance lookup      : " << loaded->GetDistanceLookup ().GetStrategyName () << std::endl;
+  std::cout << "identical tables     : " << (same ? "yes" : "no") << std::endl;
+
+  return same ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+
+/*
+ * Description:
+ * this file measures the interpolation modes of the EM channel table
+ * outside of any simulation. It keeps one distance bin every "step" of the
+ * reference table, looks the coarse table up at the distances of the bins
+ * it dropped with every mode, and reports the error against the reference
+ * values and the time spent per lookup. The coarse table can be selected
+ * for a simulation after writing it with P1906EMChannelTable::Write, and
+ * the mode through the P1906EMChannelInterpolation global value.
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/p1906-em-channel-table.h"
+#include "ns3/p1906-em-band-kernels.h"
+#include <cmath>
+#include <cfloat>
+#include <vector>
+#include <iostream>
+
+using namespace ns3;
+
+
+int main (int argc, char *argv[])
+{
+  uint32_t step = 10;
+  uint32_t iterations = 200;
+
+  CommandLine cmd;
+  cmd.AddValue("step", "one bin of the reference table out of step is kept", step);
+  cmd.AddValue("iterations", "number of passes over the dropped bins", iterations);
+  cmd.Parse(argc, argv);
+
+  Ptr<const P1906EMChannelTable> reference = P1906EMChannelTable::GetDefault ();
+  uint32_t nDistances = reference->GetNDistances ();
+  uint32_t nBands = reference->GetNBands ();
+
+  // the coarse grid keeps the last bin, so that both tables span the same distances
+  std::vector<double> distances, pathLoss, noise;
+  std::vector<uint32_t> dropped;
+  for (uint32_t d = 0; d < nDistances; d++)
+    {
+      if (d % step == 0 || d == nDistances - 1)
+        {
+          distances.push_back (reference->GetDistance (d));
+          pathLoss.insert (pathLoss.end (), reference->GetPathLoss (d), reference->GetPathLoss (d) + nBands);
+          noise.insert (noise.end (), reference->GetMolecularNoise (d), reference->GetMolecularNoise (d) + nBands);
+        }
+      else
+        {
+          dropped.push_back (d);
+        }
+    }
+  Ptr<const P1906EMChannelTable> coarse =
+    P1906EMChannelTable::Create (distances.size (), nBands, &distances[0],
+                                 reference->GetBandFrequencies (), &pathLoss[0], &noise[0]);
+
+  std::cout << "instruction set      : " << P1906EMBandKernels::GetInstructionSet () << std::endl;
+  std::cout << "[reference,coarse]   : " << nDistances << " " << coarse->GetNDistances () << " bins" << std::endl;
+  std::cout << "lookups              : " << double (iterations) * dropped.size () << std::endl;
+
+  P1906EMChannelTable::Interpolation modes[] = {
+    P1906EMChannelTable::LOWER_BIN, P1906EMChannelTable::NEAREST_BIN,
+    P1906EMChannelTable::LINEAR, P1906EMChannelTable::CUBIC
+  };
+  std::vector<double> gain (nBands);
+  std::vector<double> psd (nBands, 4.5e-9);
+  SystemWallClockMs clock;
+  for (uint32_t m = 0; m < sizeof (modes) / sizeof (modes[0]); m++)
+    {
+      // the path loss error in dB, where the reference gain is a normal double
+      double maxPathLossError = 0.;
+      double sumPathLossError = 0.;
+      uint32_t nPathLossErrors = 0;
+      double maxNoiseError = 0.;
+      double sumNoiseError = 0.;
+      for (uint32_t k = 0; k < dropped.size (); k++)
+        {
+          double distance = reference->GetDistance (dropped[k]);
+          const double *referenceGain = reference->GetPathLossGain (dropped[k]);
+          const double *referenceNoise = reference->GetMolecularNoise (dropped[k]);
+          coarse->InterpolatePathLossGain (distance, modes[m], &gain[0]);
+          for (uint32_t i = 0; i < nBands; i++)
+            {
+              if (referenceGain[i] >= DBL_MIN)
+                {
+                  double e = gain[i] > 0. ? std::fabs (10 * std::log10 (gain[i] / referenceGain[i])) : HUGE_VAL;
+                  maxPathLossError = std::max (maxPathLossError, e);
+                  sumPathLossError += e;
+                  nPathLossErrors++;
+                }
+            }
+          coarse->InterpolateMolecularNoise (distance, modes[m], &gain[0]);
+          for (uint32_t i = 0; i < nBands; i++)
+            {
+              double e = std::fabs (gain[i] - referenceNoise[i]) / referenceNoise[i];
+              maxNoiseError = std::max (maxNoiseError, e);
+              sumNoiseError += e;
+            }
+        }
+
+      // the per-reception work of P1906EMMotion: gain lookup and attenuation
+      clock.Start ();
+      for (uint32_t n = 0; n < iterations; n++)
+        {
+          for (uint32_t k = 0; k < dropped.size (); k++)
+            {
+              coarse->InterpolatePathLossGain (reference->GetDistance (dropped[k]), modes[m], &gain[0]);
+              P1906EMBandKernels::Multiply (&psd[0], &gain[0], &gain[0], nBands);
+            }
+        }
+      int64_t time = clock.End ();
+
+      std::cout << std::endl;
+      std::cout << "mode                 : " << P1906EMChannelTable::GetInterpolationName (modes[m]) << std::endl;
+      std::cout << "path loss error [dB] : mean " << sumPathLossError / nPathLossErrors
+                << " max " << maxPathLossError << std::endl;
+      std::cout << "noise relative error : mean " << sumNoiseError / (dropped.size () * nBands)
+                << " max " << maxNoiseError << std::endl;
+      std::cout << "lookup       [ns/rx]: " << time * 1e6 / (double (iterations) * dropped.size ()) << std::endl;
+    }
+
+  return 0;
+}
@@ -0,0 +1,180 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+
+
+
+/*
+ * Description:
+ * this file measures the per-reception kernels of the EM example outside of
+ * any simulation. For every distance bin of the reference channel table it
+ * attenuates a transmitted PSD both in the dB domain (the former
+ * implementation) and in the linear domain, reports the time spent by each
+ * form and checks that they agree within the documented tolerance. It then
+ * computes the Shannon capacity of every bin with the former per-band loop
+ * and with the logarithm kernel, in its EXACT and FAST precisions.
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/p1906-em-channel-table.h"
+#include "ns3/p1906-em-band-kernels.h"
+#include <cmath>
+#include <cfloat>
+#include <vector>
+#include <iostream>
+
+using namespace ns3;
+
+
+int main (int argc, char *argv[])
+{
+  uint32_t iterations = 200;
+  double txPsd = 4.5e-9;								//  [W/Hz]
+
+  CommandLine cmd;
+  cmd.AddValue("iterations", "number of passes over the distance bins", iterations);
+  cmd.AddValue("txPsd", "transmitted power spectral density [W/Hz]", txPsd);
+  cmd.Parse(argc, argv);
+
+  Ptr<const P1906EMChannelTable> table = P1906EMChannelTable::GetDefault ();
+  uint32_t nDistances = table->GetNDistances ();
+  uint32_t nBands = table->GetNBands ();
+
+  std::vector<double> dbDomain (nDistances * nBands);
+  std::vector<double> linearDomain (nDistances * nBands);
+  std::vector<double> psd (nBands, txPsd);
+
+  SystemWallClockMs clock;
+
+  // dB domain: one log10 and one pow per band
+  clock.Start ();
+  for (uint32_t k = 0; k < iterations; k++)
+    {
+      for (uint32_t d = 0; d < nDistances; d++)
+        {
+          const double *pathloss = table->GetPathLoss (d);
+          double *out = &dbDomain[d * nBands];
+          for (uint32_t i = 0; i < nBands; i++)
+            {
+              out[i] = pow(10., ((10*log10 (psd[i])) - pathloss[i])/10.);
+            }
+        }
+    }
+  int64_t dbTime = clock.End ();
+
+  // linear domain: one vectorized multiply per reception
+  clock.Start ();
+  for (uint32_t k = 0; k < iterations; k++)
+    {
+      for (uint32_t d = 0; d < nDistances; d++)
+        {
+          P1906EMBandKernels::Multiply (&psd[0], table->GetPathLossGain (d),
+                                        &linearDomain[d * nBands], nBands);
+        }
+    }
+  int64_t linearTime = clock.End ();
+
+  double maxRelativeError = 0.;
+  for (uint32_t i = 0; i < dbDomain.size (); i++)
+    {
+      if (dbDomain[i] >= DBL_MIN)
+        {
+          double e = std::fabs (linearDomain[i] - dbDomain[i]) / dbDomain[i];
+          maxRelativeError = std::max (maxRelativeError, e);
+        }
+    }
+
+  // Shannon capacity per Hz: two logarithms per band, or one kernel call
+  std::vector<double> loopCapacity (nDistances);
+  clock.Start ();
+  for (uint32_t k = 0; k < iterations; k++)
+    {
+      for (uint32_t d = 0; d < nDistances; d++)
+        {
+          const double *rx = &linearDomain[d * nBands];
+          const double *molecularnoise = table->GetMolecularNoise (d);
+          double channelCapacity = 0;
+          for (uint32_t i = 0; i < nBands; i++)
+            {
+              double boltzman = 1.380658e-23;
+              double sinr_i = rx[i]/(boltzman *molecularnoise[i]);
+              channelCapacity += log(1 + sinr_i)/log(2);
+            }
+          loopCapacity[d] = channelCapacity;
+        }
+    }
+  int64_t loopTime = clock.End ();
+
+  P1906EMBandKernels::Precision precisions[] = { P1906EMBandKernels::EXACT, P1906EMBandKernels::FAST };
+  int64_t kernelTime[2];
+  double maxCapacityError[2];
+  for (uint32_t p = 0; p < 2; p++)
+    {
+      // the kernel divides by the noise temperature, so the k_B factor goes with the signal
+      std::vector<double> kernelCapacity (nDistances);
+      std::vector<double> scaledDomain (linearDomain.size ());
+      for (uint32_t i = 0; i < scaledDomain.size (); i++)
+        {
+          scaledDomain[i] = linearDomain[i] / 1.380658e-23;
+        }
+      clock.Start ();
+      for (uint32_t k = 0; k < iterations; k++)
+        {
+          for (uint32_t d = 0; d < nDistances; d++)
+            {
+              kernelCapacity[d] = P1906EMBandKernels::SumLog2OnePlusRatio (&scaledDomain[d * nBands],
+                                                                           table->GetMolecularNoise (d), nBands,
+                                                                           HUGE_VAL, precisions[p]);
+            }
+        }
+      kernelTime[p] = clock.End ();
+
+      // the absolute error [bit/s/Hz], since the capacity vanishes at large distances
+      maxCapacityError[p] = 0.;
+      for (uint32_t d = 0; d < nDistances; d++)
+        {
+          maxCapacityError[p] = std::max (maxCapacityError[p], std::fabs (kernelCapacity[d] - loopCapacity[d]));
+        }
+    }
+
+  double receptions = double (iterations) * nDistances;
+  std::cout << "instruction set      : " << P1906EMBandKernels::GetInstructionSet () << std::endl;
+  std::cout << "receptions           : " << receptions << std::endl;
+  std::cout << "dB domain     [ns/rx]: " << dbTime * 1e6 / receptions << std::endl;
+  std::cout << "linear domain [ns/rx]: " << linearTime * 1e6 / receptions << std::endl;
+  std::cout << "speedup              : " << (linearTime > 0 ? double (dbTime) / linearTime : 0.) << std::endl;
+  std::cout << "max relative error   : " << maxRelativeError << " (tolerance 1e-12)" << std::endl;
+  std::cout << "capacity loop [ns/rx]: " << loopTime * 1e6 / receptions << std::endl;
+  std::cout << "capacity exact[ns/rx]: " << kernelTime[0] * 1e6 / receptions
+            << " error " << maxCapacityError[0] << " bit/s/Hz" << std::endl;
+  std::cout << "capacity fast [ns/rx]: " << kernelTime[1] * 1e6 / receptions
+            << " error " << maxCapacityError[1] << " bit/s/Hz" << std::endl;
+
+  return maxRelativeError <= 1e-12 && maxCapacityError[0] <= 1e-9 ? 0 : 1;
+}
@@ -37,6 +37,7 @@
 #include "extension-name-p1906-medium.h"
 #include "extension-name-p1906-net-device.h"
 #include "extension-name-p1906-motion.h"
+#include "ns3/p1906-interference.h"
 
 
 namespace ns3 {
@@ -87,6 +88,8 @@ ExtensionNameP1906ReceiverCommunicationInterface::HandleReception (Ptr<P1906Comm
 	  //ignore the received message carrier
     }
 
+  // the carrier interferes with the next ones, whether received or not
+  GetP1906Interference ()->Add (message);
 }
 
 } // namespace ns3
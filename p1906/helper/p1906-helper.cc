@@ -109,6 +109,11 @@ P1906Helper::EnableLogComponents (void)
   LogComponentEnable ("P1906Motion", LOG_LEVEL_ALL);
   LogComponentEnable ("P1906Perturbation", LOG_LEVEL_ALL);
   LogComponentEnable ("P1906Specificity", LOG_LEVEL_ALL);
+  LogComponentEnable ("P1906GridLookup", LOG_LEVEL_ALL);
+  LogComponentEnable ("P1906SpatialIndex", LOG_LEVEL_ALL);
+  LogComponentEnable ("P1906WorkerPool", LOG_LEVEL_ALL);
+  LogComponentEnable ("P1906ReceiverRegistry", LOG_LEVEL_ALL);
+  LogComponentEnable ("P1906Interference", LOG_LEVEL_ALL);
 
   LogComponentEnable ("P1906EMMessageCarrier", LOG_LEVEL_ALL);
   LogComponentEnable ("P1906EMCommunicationInterface", LOG_LEVEL_ALL);
@@ -116,7 +121,9 @@ P1906Helper::EnableLogComponents (void)
   LogComponentEnable ("P1906EMReceiverCommunicationInterface", LOG_LEVEL_ALL);
   LogComponentEnable ("P1906EMField", LOG_LEVEL_ALL);
   LogComponentEnable ("P1906EMMotion", LOG_LEVEL_ALL);
+  LogComponentEnable ("P1906EMChannelTable", LOG_LEVEL_ALL);
   LogComponentEnable ("P1906EMPerturbation", LOG_LEVEL_ALL);
+  LogComponentEnable ("P1906EMSpectrumRegistry", LOG_LEVEL_ALL);
   LogComponentEnable ("P1906EMSpecificity", LOG_LEVEL_ALL);
 
 
@@ -125,7 +132,10 @@ P1906Helper::EnableLogComponents (void)
   LogComponentEnable ("P1906MOLTransmitterCommunicationInterface", LOG_LEVEL_ALL);
   LogComponentEnable ("P1906MOLReceiverCommunicationInterface", LOG_LEVEL_ALL);
   LogComponentEnable ("P1906MOLField", LOG_LEVEL_ALL);
+  LogComponentEnable ("P1906MOLFlowGrid", LOG_LEVEL_ALL);
   LogComponentEnable ("P1906MOLMotion", LOG_LEVEL_ALL);
+  LogComponentEnable ("P1906MOLParticles", LOG_LEVEL_ALL);
+  LogComponentEnable ("P1906MOLCountingReceivers", LOG_LEVEL_ALL);
   LogComponentEnable ("P1906MOLPerturbation", LOG_LEVEL_ALL);
   LogComponentEnable ("P1906MOLSpecificity", LOG_LEVEL_ALL);
   
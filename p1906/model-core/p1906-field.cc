@@ -53,4 +53,11 @@ P1906Field::~P1906Field ()
   NS_LOG_FUNCTION (this);
 }
 
+bool
+P1906Field::IsEmpty (void) const
+{
+  // a subclass may act on the propagation without overriding this method
+  return GetInstanceTypeId () == P1906Field::GetTypeId ();
+}
+
 } // namespace ns3
@@ -53,6 +53,15 @@ public:
   P1906Field ();
   virtual ~P1906Field ();
 
+  /**
+   * \returns whether the field has no effect on the propagation, in which
+   * case P1906Medium may propagate without it through
+   * P1906Motion::PropagateLink. The default implementation returns true
+   * for a P1906Field only, and false for any subclass that does not
+   * override it.
+   */
+  virtual bool IsEmpty (void) const;
+
 private:
 };
 
@@ -0,0 +1,145 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+#include "ns3/log.h"
+
+#include "p1906-grid-lookup.h"
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("P1906GridLookup");
+
+/*
+ * A grid is considered uniform when no point deviates from the ideal
+ * evenly spaced position by more than a quarter of the step: the
+ * arithmetic estimate is then off by one bin at most, and it is corrected
+ * against the actual grid points.
+ */
+static const double g_uniformTolerance = 0.25;
+
+P1906GridLookup::P1906GridLookup ()
+  : m_grid (0),
+    m_n (0),
+    m_strategy (BINARY_SEARCH),
+    m_origin (0.),
+    m_inverseStep (0.)
+{
+}
+
+void
+P1906GridLookup::SetGrid (const double *grid, uint32_t n)
+{
+  NS_ASSERT (grid != 0 && n > 0);
+  m_grid = grid;
+  m_n = n;
+  m_strategy = BINARY_SEARCH;
+
+  if (n > 2)
+    {
+      double step = (grid[n - 1] - grid[0]) / (n - 1);
+      bool uniform = step > 0.;
+      for (uint32_t i = 1; uniform && i < n; i++)
+        {
+          uniform = std::fabs (grid[i] - (grid[0] + i * step)) <= g_uniformTolerance * step;
+        }
+      if (uniform)
+        {
+          m_strategy = UNIFORM_GRID;
+          m_origin = grid[0];
+          m_inverseStep = 1. / step;
+        }
+    }
+
+  NS_LOG_INFO ("[points,strategy]" << n << GetStrategyName ());
+}
+
+uint32_t
+P1906GridLookup::FindIndex (double x) const
+{
+  if (x <= m_grid[0])
+    {
+      return 0;
+    }
+  if (x >= m_grid[m_n - 1])
+    {
+      return m_n - 1;
+    }
+  if (m_strategy == UNIFORM_GRID)
+    {
+      return FindIndexUniform (x);
+    }
+  return FindIndexBinarySearch (x);
+}
+
+uint32_t
+P1906GridLookup::FindIndexUniform (double x) const
+{
+  uint32_t i = static_cast<uint32_t> ((x - m_origin) * m_inverseStep);
+  if (i > m_n - 2)
+    {
+      i = m_n - 2;
+    }
+  if (m_grid[i + 1] <= x)
+    {
+      i++;
+    }
+  else if (m_grid[i] > x)
+    {
+      i--;
+    }
+  return i;
+}
+
+uint32_t
+P1906GridLookup::FindIndexBinarySearch (double x) const
+{
+  const double *base = m_grid;
+  uint32_t length = m_n;
+  while (length > 1)
+    {
+      uint32_t half = length / 2;
+      base = (base[half] <= x) ? base + half : base;
+      length -= half;
+    }
+  return base - m_grid;
+}
+
+P1906GridLookup::Strategy
+P1906GridLookup::GetStrategy (void) const
+{
+  return m_strategy;
+}
+
+std::string
+P1906GridLookup::GetStrategyName (void) const
+{
+  return (m_strategy == UNIFORM_GRID) ? "uniform grid" : "binary search";
+}
+
+} // namespace ns3
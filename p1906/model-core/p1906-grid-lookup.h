@@ -0,0 +1,95 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+
+#ifndef P1906_GRID_LOOKUP
+#define P1906_GRID_LOOKUP
+
+#include <stdint.h>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * \ingroup P1906 framework
+ *
+ * \class P1906GridLookup
+ *
+ * \brief Finds the bin of a value within a sorted grid (e.g., the distance
+ * grid of a channel table).
+ *
+ * The grid is inspected once, when it is set: if its points are evenly
+ * spaced the bin is computed arithmetically in O(1), otherwise a branchless
+ * binary search is used. Both strategies return exactly the same bins.
+ */
+
+class P1906GridLookup
+{
+public:
+  enum Strategy
+  {
+    UNIFORM_GRID,
+    BINARY_SEARCH
+  };
+
+  P1906GridLookup ();
+
+  /**
+   * \param grid the strictly increasing grid points (not copied: they must
+   * outlive the lookup)
+   * \param n the number of grid points
+   */
+  void SetGrid (const double *grid, uint32_t n);
+
+  /**
+   * \param x the value to look for
+   * \return the index of the largest grid point not greater than x,
+   * clamped to the first and to the last points of the grid
+   */
+  uint32_t FindIndex (double x) const;
+
+  /**
+   * \return the strategy chosen when the grid has been set
+   */
+  Strategy GetStrategy (void) const;
+  std::string GetStrategyName (void) const;
+
+private:
+  uint32_t FindIndexUniform (double x) const;
+  uint32_t FindIndexBinarySearch (double x) const;
+
+  const double *m_grid;
+  uint32_t m_n;
+  Strategy m_strategy;
+  double m_origin;
+  double m_inverseStep;
+};
+
+}
+
+#endif /* P1906_GRID_LOOKUP */
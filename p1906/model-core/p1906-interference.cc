@@ -0,0 +1,173 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "p1906-interference.h"
+#include "p1906-message-carrier.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("P1906Interference");
+
+TypeId P1906Interference::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::P1906Interference")
+    .SetParent<Object> ();
+  return tid;
+}
+
+P1906Interference::P1906Interference ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+P1906Interference::~P1906Interference ()
+{
+  NS_LOG_FUNCTION (this);
+  m_carriers.clear ();
+}
+
+void
+P1906Interference::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  // the Specificity may be disposed already: it is not told about the carriers
+  m_carrierStart = MakeNullCallback<void, Ptr<P1906MessageCarrier> > ();
+  m_carrierEnd = MakeNullCallback<void, Ptr<P1906MessageCarrier> > ();
+  Clear ();
+  Object::DoDispose ();
+}
+
+void
+P1906Interference::Add (Ptr<P1906MessageCarrier> message)
+{
+  NS_LOG_FUNCTION (this);
+  RemoveEndedCarriers (Simulator::Now ());
+
+  Time duration = message->GetDuration ();
+  if (duration <= Seconds (0))
+    {
+      NS_LOG_FUNCTION (this << "instantaneous carrier --> not tracked");
+      return;
+    }
+
+  ActiveCarrier carrier;
+  carrier.m_start = Simulator::Now ();
+  carrier.m_message = message;
+  m_carriers.insert (std::make_pair (carrier.m_start + duration, carrier));
+  NS_LOG_FUNCTION (this << "[start,end,active]" << carrier.m_start << carrier.m_start + duration << m_carriers.size ());
+
+  if (!m_carrierStart.IsNull ())
+    {
+      m_carrierStart (message);
+    }
+}
+
+uint32_t
+P1906Interference::GetNActiveCarriers (void)
+{
+  NS_LOG_FUNCTION (this);
+  RemoveEndedCarriers (Simulator::Now ());
+  return m_carriers.size ();
+}
+
+Time
+P1906Interference::GetBusyUntil (void)
+{
+  NS_LOG_FUNCTION (this);
+  RemoveEndedCarriers (Simulator::Now ());
+  if (m_carriers.empty ())
+    {
+      return Simulator::Now ();
+    }
+  return m_carriers.rbegin ()->first;
+}
+
+void
+P1906Interference::GetOverlappingCarriers (Time start, Time end, std::vector< Ptr<P1906MessageCarrier> > &carriers)
+{
+  NS_LOG_FUNCTION (this << start << end);
+  RemoveEndedCarriers (Simulator::Now ());
+  carriers.clear ();
+  // the carriers ending after start, of which those started before end
+  for (ActiveCarriers::iterator it = m_carriers.upper_bound (start); it != m_carriers.end (); it++)
+    {
+      if (it->second.m_start < end)
+        {
+          carriers.push_back (it->second.m_message);
+        }
+    }
+}
+
+void
+P1906Interference::SetCarrierStartCallback (CarrierCallback cb)
+{
+  NS_LOG_FUNCTION (this);
+  m_carrierStart = cb;
+}
+
+void
+P1906Interference::SetCarrierEndCallback (CarrierCallback cb)
+{
+  NS_LOG_FUNCTION (this);
+  m_carrierEnd = cb;
+}
+
+void
+P1906Interference::Clear (void)
+{
+  NS_LOG_FUNCTION (this << m_carriers.size ());
+  while (!m_carriers.empty ())
+    {
+      Ptr<P1906MessageCarrier> message = m_carriers.begin ()->second.m_message;
+      m_carriers.erase (m_carriers.begin ());
+      if (!m_carrierEnd.IsNull ())
+        {
+          m_carrierEnd (message);
+        }
+    }
+}
+
+void
+P1906Interference::RemoveEndedCarriers (Time now)
+{
+  NS_LOG_FUNCTION (this << now);
+  while (!m_carriers.empty () && m_carriers.begin ()->first <= now)
+    {
+      Ptr<P1906MessageCarrier> message = m_carriers.begin ()->second.m_message;
+      m_carriers.erase (m_carriers.begin ());
+      NS_LOG_FUNCTION (this << "carrier ended, active" << m_carriers.size ());
+      if (!m_carrierEnd.IsNull ())
+        {
+          m_carrierEnd (message);
+        }
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,133 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+
+#ifndef P1906_INTERFERENCE
+#define P1906_INTERFERENCE
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/callback.h"
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+class P1906MessageCarrier;
+
+/**
+ * \ingroup P1906 framework
+ *
+ * \class P1906Interference
+ *
+ * \brief Set of the message carriers active at a receiver. A carrier is
+ * active from its arrival to its arrival plus
+ * P1906MessageCarrier::GetDuration; the carriers are ordered by end time,
+ * so that insertions cost O(log k) and the ended ones are removed from
+ * the front when the set is next used.
+ *
+ * The Specificity component may use it, through the receiver, to account
+ * for the carriers overlapping the one under evaluation. The callbacks
+ * let it keep an accumulated quantity up to date instead of visiting
+ * every active carrier at each reception.
+ */
+
+class P1906Interference : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  P1906Interference ();
+  virtual ~P1906Interference ();
+
+  typedef Callback<void, Ptr<P1906MessageCarrier> > CarrierCallback;
+
+  /**
+   * \brief adds a carrier arriving now; carriers with a null duration are
+   * never active and are ignored
+   */
+  void Add (Ptr<P1906MessageCarrier> message);
+
+  /**
+   * \brief removes the carriers ended by now, calling the end callback for
+   * each of them; the other methods do it first as well
+   */
+  void RemoveEndedCarriers (Time now);
+
+  /**
+   * \returns the number of the carriers active now
+   */
+  uint32_t GetNActiveCarriers (void);
+  /**
+   * \returns the end of the last active carrier, or now if there is none
+   */
+  Time GetBusyUntil (void);
+  /**
+   * \param start the start of the interval
+   * \param end the end of the interval (excluded)
+   * \param carriers filled with the active carriers overlapping it, by end
+   * time
+   */
+  void GetOverlappingCarriers (Time start, Time end, std::vector< Ptr<P1906MessageCarrier> > &carriers);
+
+  /**
+   * \param cb called when a carrier becomes active
+   */
+  void SetCarrierStartCallback (CarrierCallback cb);
+  /**
+   * \param cb called when an active carrier ends, before the carrier that
+   * arrives or is evaluated at that time
+   */
+  void SetCarrierEndCallback (CarrierCallback cb);
+
+  /**
+   * \brief removes all the carriers, calling the end callback for each of
+   * them, so that an accumulated quantity returns to its idle value
+   */
+  void Clear (void);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  struct ActiveCarrier
+  {
+    Time m_start;
+    Ptr<P1906MessageCarrier> m_message;
+  };
+  typedef std::multimap<Time, ActiveCarrier> ActiveCarriers;
+
+  ActiveCarriers m_carriers;
+  CarrierCallback m_carrierStart;
+  CarrierCallback m_carrierEnd;
+};
+
+}
+
+#endif /* P1906_INTERFERENCE */
@@ -34,13 +34,20 @@
 #include "ns3/node.h"
 #include "ns3/log.h"
 #include "ns3/pointer.h"
+#include "ns3/mobility-model.h"
+#include "ns3/callback.h"
 #include "p1906-medium.h"
 #include "p1906-communication-interface.h"
+#include "p1906-net-device.h"
 #include "p1906-field.h"
 #include "p1906-message-carrier.h"
 #include "p1906-receiver-communication-interface.h"
 #include "p1906-specificity.h"
 #include "p1906-motion.h"
+#include "p1906-perturbation.h"
+#include "p1906-transmitter-communication-interface.h"
+#include <algorithm>
+#include <limits>
 
 
 NS_LOG_COMPONENT_DEFINE ("P1906Medium");
@@ -49,6 +56,37 @@ namespace ns3 {
 
 NS_OBJECT_ENSURE_REGISTERED (P1906Medium);
 
+// below this many receivers per thread the synchronization costs more than the work
+static const uint32_t g_minLinksPerThread = 64;
+
+namespace {
+
+struct IsInterface
+{
+  IsInterface (const P1906ReceiverRegistry &registry, const P1906CommunicationInterface *i)
+    : m_registry (registry), m_interface (i) {}
+  bool operator() (uint32_t id) const
+  {
+    return m_registry.GetCommunicationInterface (id) == m_interface;
+  }
+  const P1906ReceiverRegistry &m_registry;
+  const P1906CommunicationInterface *m_interface;
+};
+
+struct IsOffChannel
+{
+  IsOffChannel (const P1906ReceiverRegistry &registry, uint64_t channel)
+    : m_registry (registry), m_channel (channel) {}
+  bool operator() (uint32_t id) const
+  {
+    return !m_registry.Accepts (id, m_channel);
+  }
+  const P1906ReceiverRegistry &m_registry;
+  uint64_t m_channel;
+};
+
+}
+
 TypeId
 P1906Medium::GetTypeId ()
 {
@@ -65,11 +103,22 @@ P1906Medium::P1906Medium ()
   NS_LOG_FUNCTION (this);
   m_communicationInterfaces = new P1906CommunicationInterfaces ();
   m_motion = 0;
+  m_cullingRadius = 0.;
+  m_automaticCulling = false;
+  m_specificitiesCollected = false;
+  m_unboundedReceivers = false;
+  m_staticLinkCache = false;
+  m_channelFiltering = false;
+  m_batchedDelivery = false;
+  m_delivering = false;
+  m_receptionSequence = 0;
+  m_receptionBatch = 0;
 }
 
 P1906Medium::~P1906Medium ()
 {
   NS_LOG_FUNCTION (this);
+  ClearReceptionBatches ();
   m_communicationInterfaces = 0;
   m_motion = 0;
 }
@@ -80,6 +129,11 @@ P1906Medium::DoDispose ()
   Channel::DoDispose ();
   m_communicationInterfaces = 0;
   m_motion = 0;
+  m_registry.Clear ();
+  m_specificities.clear ();
+  m_specificitiesCollected = false;
+  m_deliveryEvent.Cancel ();
+  ClearReceptionBatches ();
   NS_LOG_FUNCTION (this);
 }
 
@@ -118,30 +172,352 @@ P1906Medium::HandleTransmission (Ptr<P1906CommunicationInterface> src,
 {
   NS_LOG_FUNCTION (this);
 
-  std::vector< Ptr<P1906CommunicationInterface> >::iterator it;
-  for (it = m_communicationInterfaces->begin (); it != m_communicationInterfaces->end (); it++)
+  if (!m_batchedDelivery)
     {
-	  Ptr<P1906CommunicationInterface> dst = *it;
-	  if (dst != src)
-	    {
-          Ptr<P1906MessageCarrier> receivedMessageCarrier;
-          double delay;
+      PropagateToReceivers (src, message, field);
+      return;
+    }
 
-          if (m_motion)
-            {
-        	   delay = m_motion->ComputePropagationDelay (src, dst, message, field);
-               receivedMessageCarrier = m_motion->CalculateReceivedMessageCarrier(src, dst, message, field);
-            }
-          else
-            {
-              NS_LOG_FUNCTION (this << "The Motion component has not been configured");
-              receivedMessageCarrier = message;
-              delay = 0.;
-            }
+  ReceptionBatch *batch = new ReceptionBatch ();
+  m_receptionBatch = batch;
+  PropagateToReceivers (src, message, field);
+  m_receptionBatch = 0;
+  EnqueueReceptionBatch (batch);
+}
+
+void
+P1906Medium::PropagateToReceivers (Ptr<P1906CommunicationInterface> src,
+                                   Ptr<P1906MessageCarrier> message,
+                                   Ptr<P1906Field> field)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (!m_registry.IsBuilt ())
+    {
+      m_registry.Build (*m_communicationInterfaces);
+    }
+  m_registry.Refresh ();
+
+  Ptr<MobilityModel> srcMobility = src->GetP1906NetDevice ()->GetNode ()->GetObject<MobilityModel> ();
+  double radius = ComputeTransmissionRange (src);
+  uint64_t channel = GetTransmissionChannel (src);
+  const P1906CommunicationInterface *source = PeekPointer (src);
+
+  uint32_t srcId;
+  if (m_staticLinkCache && srcMobility && m_registry.IsLinkCacheUsable () && m_registry.FindId (source, srcId))
+    {
+      if (radius < std::numeric_limits<double>::infinity ())
+        {
+          PrepareSpatialIndex (radius);
+        }
+      const P1906ReceiverRegistry::LinkRow &row = m_registry.GetLinks (srcId, radius, channel);
+      PropagateMessageCarriers (src, srcMobility, row.m_ids, &row.m_distances, message, field);
+      return;
+    }
+
+  // receivers are served in the order of the communication interfaces
+  std::vector<uint32_t> ids;
+  if (srcMobility && radius < std::numeric_limits<double>::infinity ())
+    {
+      PrepareSpatialIndex (radius);
+      m_registry.Query (srcMobility->GetPosition (), radius, ids);
+      NS_LOG_FUNCTION (this << "receivers within the culling radius" << ids.size () << m_registry.GetN ());
+      if (channel != 0)
+        {
+          ids.erase (std::remove_if (ids.begin (), ids.end (), IsOffChannel (m_registry, channel)), ids.end ());
+        }
+    }
+  else
+    {
+      m_registry.GetReceivers (channel, ids);
+    }
+  NS_LOG_FUNCTION (this << "receivers on the channel" << channel << ids.size ());
+
+  ids.erase (std::remove_if (ids.begin (), ids.end (), IsInterface (m_registry, source)), ids.end ());
+
+  PropagateMessageCarriers (src, srcMobility, ids, 0, message, field);
+}
+
+void
+P1906Medium::PrepareSpatialIndex (double radius)
+{
+  /*
+   * The cells follow the largest radius so far: they only grow, when a
+   * radius exceeds 4 cells, so that transmitters of different ranges do not
+   * rebuild the index in turn. A smaller radius visits fewer, larger cells.
+   */
+  double cellSize = m_registry.GetCellSize ();
+  if (!m_registry.HasSpatialIndex () || radius > 4. * cellSize)
+    {
+      m_registry.SetCellSize (radius > 0. ? radius : cellSize);
+    }
+}
+
+void
+P1906Medium::BuildLinkCache (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_staticLinkCache)
+    {
+      return;
+    }
+  if (!m_registry.IsBuilt ())
+    {
+      m_registry.Build (*m_communicationInterfaces);
+    }
+  if (!m_registry.IsLinkCacheUsable ())
+    {
+      NS_LOG_FUNCTION (this << "moving or unlocated receivers: the links are not cached");
+      return;
+    }
+
+  // the radii are computed here, the rows on the worker threads
+  uint32_t n = m_registry.GetN ();
+  std::vector<double> radii (n);
+  std::vector<uint64_t> channels (n);
+  for (uint32_t id = 0; id < n; id++)
+    {
+      channels[id] = GetTransmissionChannel (m_registry.GetCommunicationInterface (id));
+      radii[id] = ComputeTransmissionRange (m_registry.GetCommunicationInterface (id));
+      if (radii[id] < std::numeric_limits<double>::infinity ())
+        {
+          PrepareSpatialIndex (radii[id]);
+        }
+    }
+  if (n == 0)
+    {
+      return;
+    }
+  // the first row is built here, which also allocates the others
+  m_registry.GetLinks (0, radii[0], channels[0]);
+
+  P1906ReceiverRegistry *registry = &m_registry;
+  const double *radius = &radii[0];
+  const uint64_t *channel = &channels[0];
+  m_workerPool.Run (n - 1, [registry, radius, channel] (uint32_t begin, uint32_t end)
+    {
+      for (uint32_t id = begin + 1; id < end + 1; id++)
+        {
+          registry->BuildLinks (id, radius[id], channel[id]);
+        }
+    });
+}
+
+void
+P1906Medium::PropagateMessageCarriers (Ptr<P1906CommunicationInterface> src,
+                                       Ptr<MobilityModel> srcMobility,
+                                       const std::vector<uint32_t> &ids,
+                                       const std::vector<double> *distances,
+                                       Ptr<P1906MessageCarrier> message,
+                                       Ptr<P1906Field> field)
+{
+  NS_LOG_FUNCTION (this << ids.size ());
+  uint32_t n = ids.size ();
+
+  if (!m_motion || !m_motion->IsThreadSafe () || (field && !field->IsEmpty ()) || !srcMobility || m_registry.GetNUnlocated () > 0 || n == 0)
+    {
+      for (uint32_t i = 0; i < n; i++)
+        {
+          PropagateMessageCarrier (src, m_registry.GetCommunicationInterface (ids[i]), message, field);
+        }
+      return;
+    }
+
+  // first stage, on the simulator thread: distances and received message carriers
+  std::vector<double> computed;
+  if (!distances)
+    {
+      m_registry.GetDistances (srcMobility->GetPosition (), ids, computed);
+      distances = &computed;
+    }
+
+  std::vector<P1906Motion::Link> links (n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      links[i].m_distance = (*distances)[i];
+      m_motion->PrepareLink (message, links[i]);
+    }
+
+  // second stage, possibly on the worker threads: propagation of every link
+  const P1906Motion *motion = PeekPointer (m_motion);
+  P1906Motion::Link *first = &links[0];
+  P1906WorkerPool::Job job = [motion, first] (uint32_t begin, uint32_t end)
+    {
+      for (uint32_t i = begin; i < end; i++)
+        {
+          motion->PropagateLink (first[i]);
+        }
+    };
+  if (m_workerPool.GetNThreads () > 1 && n >= m_workerPool.GetNThreads () * g_minLinksPerThread)
+    {
+      NS_LOG_FUNCTION (this << "concurrent propagation" << m_workerPool.GetNThreads ());
+      m_workerPool.Run (n, job);
+    }
+  else
+    {
+      job (0, n);
+    }
+
+  // third stage, on the simulator thread: receptions in the order of the receivers
+  for (uint32_t i = 0; i < n; i++)
+    {
+      ScheduleReception (src, m_registry.GetCommunicationInterface (ids[i]), links[i].m_received, links[i].m_delay);
+    }
+}
+
+void
+P1906Medium::PropagateMessageCarrier (Ptr<P1906CommunicationInterface> src,
+                                      Ptr<P1906CommunicationInterface> dst,
+                                      Ptr<P1906MessageCarrier> message,
+                                      Ptr<P1906Field> field)
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<P1906MessageCarrier> receivedMessageCarrier;
+  double delay;
+
+  if (m_motion)
+    {
+      delay = m_motion->ComputePropagationDelay (src, dst, message, field);
+      receivedMessageCarrier = m_motion->CalculateReceivedMessageCarrier(src, dst, message, field);
+    }
+  else
+    {
+      NS_LOG_FUNCTION (this << "The Motion component has not been configured");
+      receivedMessageCarrier = message;
+      delay = 0.;
+    }
+
+  ScheduleReception (src, dst, receivedMessageCarrier, delay);
+}
+
+void
+P1906Medium::ScheduleReception (Ptr<P1906CommunicationInterface> src,
+                                Ptr<P1906CommunicationInterface> dst,
+                                Ptr<P1906MessageCarrier> receivedMessageCarrier,
+                                double delay)
+{
+  if (m_receptionBatch)
+    {
+      PendingReception reception;
+      reception.m_time = Simulator::Now () + Seconds (delay);
+      reception.m_sequence = m_receptionSequence++;
+      reception.m_src = src;
+      reception.m_dst = dst;
+      reception.m_message = receivedMessageCarrier;
+      m_receptionBatch->m_receptions.push_back (reception);
+      return;
+    }
+
+  Simulator::Schedule(Seconds (delay), &P1906Medium::HandleReception, this, src, dst, receivedMessageCarrier);
+}
+
+bool
+P1906Medium::ArrivesBefore (const PendingReception &a, const PendingReception &b)
+{
+  return a.m_time < b.m_time;
+}
+
+bool
+P1906Medium::ReceptionBatchOrder::operator() (const ReceptionBatch *a, const ReceptionBatch *b) const
+{
+  // std::push_heap keeps the largest element first: the latest arrival loses
+  const PendingReception &ra = a->m_receptions[a->m_next];
+  const PendingReception &rb = b->m_receptions[b->m_next];
+  if (ra.m_time != rb.m_time)
+    {
+      return ra.m_time > rb.m_time;
+    }
+  return ra.m_sequence > rb.m_sequence;
+}
 
-          Simulator::Schedule(Seconds (delay), &P1906Medium::HandleReception, this, src, dst, receivedMessageCarrier);
-	    }
+void
+P1906Medium::EnqueueReceptionBatch (ReceptionBatch *batch)
+{
+  NS_LOG_FUNCTION (this << batch->m_receptions.size ());
+  if (batch->m_receptions.empty ())
+    {
+      delete batch;
+      return;
     }
+
+  // stable: the receptions arriving together keep the order of the receivers
+  std::stable_sort (batch->m_receptions.begin (), batch->m_receptions.end (), ArrivesBefore);
+  batch->m_next = 0;
+  m_receptionBatches.push_back (batch);
+  std::push_heap (m_receptionBatches.begin (), m_receptionBatches.end (), ReceptionBatchOrder ());
+  ScheduleDelivery ();
+}
+
+void
+P1906Medium::ScheduleDelivery (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_delivering || m_receptionBatches.empty ())
+    {
+      return;
+    }
+
+  const ReceptionBatch *first = m_receptionBatches.front ();
+  Time next = first->m_receptions[first->m_next].m_time;
+  if (m_deliveryEvent.IsRunning ())
+    {
+      if (m_deliveryTime <= next)
+        {
+          return;
+        }
+      m_deliveryEvent.Cancel ();
+    }
+  m_deliveryTime = next;
+  m_deliveryEvent = Simulator::Schedule (next - Simulator::Now (), &P1906Medium::DeliverReceptions, this);
+}
+
+void
+P1906Medium::DeliverReceptions (void)
+{
+  NS_LOG_FUNCTION (this);
+  Time now = Simulator::Now ();
+
+  // receptions due now that are generated while delivering are handed over too
+  m_delivering = true;
+  while (!m_receptionBatches.empty ())
+    {
+      ReceptionBatch *batch = m_receptionBatches.front ();
+      PendingReception &reception = batch->m_receptions[batch->m_next];
+      if (reception.m_time > now)
+        {
+          break;
+        }
+      std::pop_heap (m_receptionBatches.begin (), m_receptionBatches.end (), ReceptionBatchOrder ());
+      m_receptionBatches.pop_back ();
+
+      HandleReception (reception.m_src, reception.m_dst, reception.m_message);
+      reception.m_message = 0;
+
+      batch->m_next++;
+      if (batch->m_next < batch->m_receptions.size ())
+        {
+          m_receptionBatches.push_back (batch);
+          std::push_heap (m_receptionBatches.begin (), m_receptionBatches.end (), ReceptionBatchOrder ());
+        }
+      else
+        {
+          delete batch;
+        }
+    }
+  m_delivering = false;
+
+  ScheduleDelivery ();
+}
+
+void
+P1906Medium::ClearReceptionBatches (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<ReceptionBatch*>::iterator it = m_receptionBatches.begin (); it != m_receptionBatches.end (); it++)
+    {
+      delete *it;
+    }
+  m_receptionBatches.clear ();
 }
 
 void
@@ -157,6 +533,8 @@ P1906Medium::AddP1906CommunicationInterface (Ptr<P1906CommunicationInterface> i)
 {
   NS_LOG_FUNCTION (this);
   m_communicationInterfaces->push_back (i);
+  m_registry.Clear ();
+  m_specificitiesCollected = false;
 }
 
 void
@@ -164,6 +542,8 @@ P1906Medium::SetP1906CommunicationInterfaces (P1906CommunicationInterfaces* i)
 {
   NS_LOG_FUNCTION (this);
   m_communicationInterfaces = i;
+  m_registry.Clear ();
+  m_specificitiesCollected = false;
 }
 
 P1906Medium::P1906CommunicationInterfaces*
@@ -173,6 +553,181 @@ P1906Medium::GetP1906CommunicationInterfaces ()
   return m_communicationInterfaces;
 }
 
+void
+P1906Medium::SetCullingRadius (double radius)
+{
+  NS_LOG_FUNCTION (this << radius);
+  NS_ASSERT (radius >= 0.);
+  m_cullingRadius = radius;
+}
+
+double
+P1906Medium::GetCullingRadius (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_cullingRadius;
+}
+
+void
+P1906Medium::SetAutomaticCulling (bool enabled)
+{
+  NS_LOG_FUNCTION (this << enabled);
+  m_automaticCulling = enabled;
+}
+
+bool
+P1906Medium::GetAutomaticCulling (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_automaticCulling;
+}
+
+void
+P1906Medium::SetBatchedDelivery (bool enabled)
+{
+  NS_LOG_FUNCTION (this << enabled);
+  m_batchedDelivery = enabled;
+}
+
+bool
+P1906Medium::GetBatchedDelivery (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_batchedDelivery;
+}
+
+void
+P1906Medium::SetNThreads (uint32_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+  m_workerPool.SetNThreads (n);
+}
 
+uint32_t
+P1906Medium::GetNThreads (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_workerPool.GetNThreads ();
+}
+
+void
+P1906Medium::SetStaticLinkCache (bool enabled)
+{
+  NS_LOG_FUNCTION (this << enabled);
+  m_staticLinkCache = enabled;
+  m_registry.SetLinkCache (enabled);
+  if (enabled)
+    {
+      Simulator::ScheduleNow (&P1906Medium::BuildLinkCache, this);
+    }
+}
+
+bool
+P1906Medium::GetStaticLinkCache (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_staticLinkCache;
+}
+
+void
+P1906Medium::SetChannelFiltering (bool enabled)
+{
+  NS_LOG_FUNCTION (this << enabled);
+  m_channelFiltering = enabled;
+}
+
+bool
+P1906Medium::GetChannelFiltering (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_channelFiltering;
+}
+
+uint64_t
+P1906Medium::GetTransmissionChannel (Ptr<P1906CommunicationInterface> src)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_channelFiltering)
+    {
+      return 0;
+    }
+  Ptr<P1906TransmitterCommunicationInterface> tx = src->GetP1906TransmitterCommunicationInterface ();
+  if (!tx || !tx->GetP1906Perturbation ())
+    {
+      return 0;
+    }
+  return tx->GetP1906Perturbation ()->GetChannel ();
+}
+
+double
+P1906Medium::ComputeTransmissionRange (Ptr<P1906CommunicationInterface> src)
+{
+  NS_LOG_FUNCTION (this);
+  double range = std::numeric_limits<double>::infinity ();
+  if (m_cullingRadius > 0.)
+    {
+      range = m_cullingRadius;
+    }
+  if (!m_automaticCulling)
+    {
+      return range;
+    }
+
+  Ptr<P1906Perturbation> perturbation = src->GetP1906TransmitterCommunicationInterface ()->GetP1906Perturbation ();
+  if (!perturbation)
+    {
+      return range;
+    }
+  if (m_motion)
+    {
+      range = std::min (range, m_motion->GetMaxRange (perturbation));
+    }
+
+  if (!m_specificitiesCollected)
+    {
+      /*
+       * The distinct Specificity components. A receiver without one accepts
+       * everything; one that uses the interference must get every carrier,
+       * since P1906Interference only sees the delivered ones.
+       */
+      m_specificities.clear ();
+      m_unboundedReceivers = false;
+      std::vector< Ptr<P1906CommunicationInterface> >::iterator it;
+      for (it = m_communicationInterfaces->begin (); it != m_communicationInterfaces->end (); it++)
+        {
+          Ptr<P1906ReceiverCommunicationInterface> rx = (*it)->GetP1906ReceiverCommunicationInterface ();
+          Ptr<P1906Specificity> specificity;
+          if (rx)
+            {
+              specificity = rx->GetP1906Specificity ();
+            }
+          if (!specificity || specificity->UsesInterference ())
+            {
+              m_unboundedReceivers = true;
+            }
+          else if (std::find (m_specificities.begin (), m_specificities.end (), specificity) == m_specificities.end ())
+            {
+              m_specificities.push_back (specificity);
+            }
+        }
+      m_specificitiesCollected = true;
+    }
+
+  if (m_unboundedReceivers)
+    {
+      return range;
+    }
+
+  double rxRange = 0.;
+  std::vector< Ptr<P1906Specificity> >::iterator s;
+  for (s = m_specificities.begin (); s != m_specificities.end () && rxRange < range; s++)
+    {
+      rxRange = std::max (rxRange, (*s)->GetMaxRange (perturbation));
+    }
+  range = std::min (range, rxRange);
+
+  NS_LOG_FUNCTION (this << "transmission range" << range);
+  return range;
+}
 
 } // namespace ns3
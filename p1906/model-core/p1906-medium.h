@@ -33,7 +33,10 @@
 #include "ns3/net-device.h"
 #include "ns3/channel.h"
 #include "ns3/packet.h"
-
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/p1906-receiver-registry.h"
+#include "ns3/p1906-worker-pool.h"
 
 namespace ns3 {
 
@@ -41,6 +44,8 @@ class P1906CommunicationInterface;
 class P1906MessageCarrier;
 class P1906Field;
 class P1906Motion;
+class P1906Specificity;
+class MobilityModel;
 
 
 /**
@@ -92,10 +97,157 @@ public:
   void SetP1906CommunicationInterfaces (P1906CommunicationInterfaces* i);
   P1906CommunicationInterfaces* GetP1906CommunicationInterfaces ();
 
+  /**
+   * \param radius the distance [m] beyond which a transmission is not
+   * propagated to a communication interface, or 0 to propagate it to all
+   * of them (the default)
+   *
+   * When set, only the receivers the P1906ReceiverRegistry finds within the
+   * radius are handed to the Motion and scheduled for reception.
+   * Communication interfaces whose node has no MobilityModel are always
+   * served.
+   */
+  void SetCullingRadius (double radius);
+  double GetCullingRadius (void) const;
+
+  /**
+   * \param enabled whether to derive the culling radius of each transmission
+   * from the components: the smaller of the P1906Motion::GetMaxRange and of
+   * the largest P1906Specificity::GetMaxRange among the receivers, for the
+   * Perturbation of the transmitter. A culling radius set through
+   * SetCullingRadius further bounds it. Disabled by default.
+   *
+   * The Specificity bound is not applied when a receiver has no
+   * Specificity, which accepts everything, or one that
+   * P1906Specificity::UsesInterference, to which the carriers it rejects
+   * still interfere. Only the Motion and the culling radius bound the
+   * transmissions then.
+   */
+  void SetAutomaticCulling (bool enabled);
+  bool GetAutomaticCulling (void) const;
+
+  /**
+   * \param enabled whether to deliver the message carriers through a single
+   * simulator event per medium instead of one event per receiver. Disabled
+   * by default.
+   *
+   * The receptions of each transmission are sorted by arrival time once and
+   * merged with the pending ones; the delivery event fires at the earliest
+   * arrival, hands over every reception due and reschedules itself. The
+   * receptions keep the timestamps and the relative order they have with one
+   * event each; only their order with respect to other simulator events
+   * expiring at the same time may differ.
+   */
+  void SetBatchedDelivery (bool enabled);
+  bool GetBatchedDelivery (void) const;
+
+  /**
+   * \param n the number of threads propagating a transmission, 1 (the
+   * default) for a serial evaluation
+   *
+   * The receivers are evaluated concurrently only when the Motion is
+   * P1906Motion::IsThreadSafe, the Field P1906Field::IsEmpty, and they are
+   * numerous enough. Positions and received message carriers are prepared,
+   * and receptions scheduled, on the simulator thread in the order of the
+   * receivers, so the simulation is identical to the serial one.
+   */
+  void SetNThreads (uint32_t n);
+  uint32_t GetNThreads (void) const;
+
+  /**
+   * \param enabled whether to cache, for each transmitter, the receivers
+   * within its culling radius and their distances. Disabled by default.
+   *
+   * When enabled, the cache is built at the start of the simulation, on the
+   * worker threads, and used as long as no receiver is moving; a course
+   * change updates the row and the column of the receiver involved.
+   */
+  void SetStaticLinkCache (bool enabled);
+  bool GetStaticLinkCache (void) const;
+
+  /**
+   * \param enabled whether a transmission visits only the receivers whose
+   * Specificity is on the channel of the Perturbation of the transmitter
+   * (see P1906Perturbation::GetChannel). Disabled by default.
+   *
+   * The receivers are grouped by channel when the medium first registers
+   * them; a later change of the channel of a Specificity is not followed.
+   */
+  void SetChannelFiltering (bool enabled);
+  bool GetChannelFiltering (void) const;
+
 private:
+  struct PendingReception
+  {
+    Time m_time;
+    uint64_t m_sequence;
+    Ptr<P1906CommunicationInterface> m_src;
+    Ptr<P1906CommunicationInterface> m_dst;
+    Ptr<P1906MessageCarrier> m_message;
+  };
+
+  /// the receptions of one transmission, sorted by arrival time
+  struct ReceptionBatch
+  {
+    std::vector<PendingReception> m_receptions;
+    uint32_t m_next;
+  };
+
+  struct ReceptionBatchOrder
+  {
+    bool operator() (const ReceptionBatch *a, const ReceptionBatch *b) const;
+  };
+
+  void PropagateToReceivers (Ptr<P1906CommunicationInterface> src,
+                             Ptr<P1906MessageCarrier> message,
+                             Ptr<P1906Field> field);
+  static bool ArrivesBefore (const PendingReception &a, const PendingReception &b);
+  void EnqueueReceptionBatch (ReceptionBatch *batch);
+  void ScheduleDelivery (void);
+  void DeliverReceptions (void);
+  void ClearReceptionBatches (void);
+
+  void PropagateMessageCarriers (Ptr<P1906CommunicationInterface> src,
+                                 Ptr<MobilityModel> srcMobility,
+                                 const std::vector<uint32_t> &ids,
+                                 const std::vector<double> *distances,
+                                 Ptr<P1906MessageCarrier> message,
+                                 Ptr<P1906Field> field);
+  void PrepareSpatialIndex (double radius);
+  void BuildLinkCache (void);
+  void PropagateMessageCarrier (Ptr<P1906CommunicationInterface> src,
+                                Ptr<P1906CommunicationInterface> dst,
+                                Ptr<P1906MessageCarrier> message,
+                                Ptr<P1906Field> field);
+  void ScheduleReception (Ptr<P1906CommunicationInterface> src,
+                          Ptr<P1906CommunicationInterface> dst,
+                          Ptr<P1906MessageCarrier> receivedMessageCarrier,
+                          double delay);
+  double ComputeTransmissionRange (Ptr<P1906CommunicationInterface> src);
+  uint64_t GetTransmissionChannel (Ptr<P1906CommunicationInterface> src);
+
   P1906CommunicationInterfaces* m_communicationInterfaces;
   Ptr<P1906Motion> m_motion;
 
+  double m_cullingRadius;
+  bool m_automaticCulling;
+  bool m_specificitiesCollected;
+  bool m_unboundedReceivers;
+  std::vector< Ptr<P1906Specificity> > m_specificities;
+  P1906ReceiverRegistry m_registry;
+  bool m_staticLinkCache;
+  bool m_channelFiltering;
+
+  bool m_batchedDelivery;
+  bool m_delivering;
+  uint64_t m_receptionSequence;
+  ReceptionBatch *m_receptionBatch;
+  std::vector<ReceptionBatch*> m_receptionBatches;
+  EventId m_deliveryEvent;
+  Time m_deliveryTime;
+
+  P1906WorkerPool m_workerPool;
+
 protected:
   virtual void DoDispose ();
 };
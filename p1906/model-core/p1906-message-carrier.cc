@@ -69,5 +69,19 @@ P1906MessageCarrier::GetMessage ()
   return m_message;
 }
 
+Time
+P1906MessageCarrier::GetStartTime (void)
+{
+  NS_LOG_FUNCTION (this);
+  return Seconds (0);
+}
+
+Time
+P1906MessageCarrier::GetDuration (void)
+{
+  NS_LOG_FUNCTION (this);
+  return Seconds (0);
+}
+
 
 } // namespace ns3
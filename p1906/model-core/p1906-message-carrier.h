@@ -57,6 +57,17 @@ public:
   void SetMessage (Ptr<Packet> message);
   Ptr<Packet> GetMessage ();
 
+  /**
+   * \returns the time the carrier was created by the Perturbation, or 0 if
+   * the technology does not keep it (the default)
+   */
+  virtual Time GetStartTime (void);
+  /**
+   * \returns how long the carrier is active at a receiver, or 0 for an
+   * instantaneous carrier (the default), which never interferes
+   */
+  virtual Time GetDuration (void);
+
 private:
 
   Ptr<Packet> m_message;
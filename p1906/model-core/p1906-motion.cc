@@ -33,6 +33,8 @@
 #include "p1906-communication-interface.h"
 #include "p1906-message-carrier.h"
 #include "p1906-field.h"
+#include "p1906-perturbation.h"
+#include <limits>
 
 namespace ns3 {
 
@@ -77,5 +79,33 @@ P1906Motion::CalculateReceivedMessageCarrier(Ptr<P1906CommunicationInterface> sr
   return message;
 }
 
+double
+P1906Motion::GetMaxRange (Ptr<P1906Perturbation> perturbation)
+{
+  NS_LOG_FUNCTION (this << "apply default behavior: unlimited range");
+  return std::numeric_limits<double>::infinity ();
+}
+
+bool
+P1906Motion::IsThreadSafe (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return false;
+}
+
+void
+P1906Motion::PrepareLink (Ptr<P1906MessageCarrier> message, Link &link)
+{
+  NS_LOG_FUNCTION (this);
+  link.m_received = message;
+  link.m_values = 0;
+}
+
+void
+P1906Motion::PropagateLink (Link &link) const
+{
+  link.m_delay = 0.;
+}
+
 
 } // namespace ns3
@@ -49,6 +49,7 @@ namespace ns3 {
 class P1906MessageCarrier;
 class P1906CommunicationInterface;
 class P1906Field;
+class P1906Perturbation;
 
 class P1906Motion : public Object
 {
@@ -68,6 +69,48 @@ public:
   		                                                           Ptr<P1906MessageCarrier> message,
   		                                                           Ptr<P1906Field> field);
 
+  /**
+   * \param perturbation the Perturbation of the transmitter
+   * \returns the distance [m] beyond which the message carriers produced by
+   * perturbation can not be propagated, or infinity if there is none. The
+   * default implementation returns infinity.
+   */
+  virtual double GetMaxRange (Ptr<P1906Perturbation> perturbation);
+
+  /**
+   * \brief the propagation of a message carrier towards one receiver, split
+   * so that P1906Medium can evaluate many receivers concurrently
+   */
+  struct Link
+  {
+    double m_distance;                    ///< set by the medium [m]
+    Ptr<P1906MessageCarrier> m_received;  ///< set by PrepareLink
+    double *m_values;                     ///< set by PrepareLink, values of m_received PropagateLink may modify
+    double m_delay;                       ///< set by PropagateLink [s]
+  };
+
+  /**
+   * \returns whether the Motion implements PrepareLink and PropagateLink,
+   * which P1906Medium then calls instead of ComputePropagationDelay and
+   * CalculateReceivedMessageCarrier, from the distances it caches and
+   * possibly concurrently on distinct links. PropagateLink must give the
+   * same results without logging, allocating or copying Ptr. The default
+   * implementation returns false.
+   */
+  virtual bool IsThreadSafe (void) const;
+
+  /**
+   * \brief called on the simulator thread before PropagateLink; the default
+   * implementation shares the transmitted message carrier
+   */
+  virtual void PrepareLink (Ptr<P1906MessageCarrier> message, Link &link);
+
+  /**
+   * \brief computes the delay and the received message carrier of a link
+   * prepared by PrepareLink; the default implementation gives no delay
+   */
+  virtual void PropagateLink (Link &link) const;
+
 private:
 
 };
@@ -64,4 +64,11 @@ P1906Perturbation::CreateMessageCarrier (Ptr<Packet> p)
   return carrier;
 }
 
+uint64_t
+P1906Perturbation::GetChannel (void)
+{
+  NS_LOG_FUNCTION (this);
+  return 0;
+}
+
 } // namespace ns3
@@ -60,6 +60,13 @@ public:
 
   virtual Ptr<P1906MessageCarrier> CreateMessageCarrier (Ptr<Packet> p);
 
+  /**
+   * \returns the channel the message carriers are created on, matched
+   * against P1906Specificity::GetChannel, or 0 (the default) when they may be
+   * accepted on any channel
+   */
+  virtual uint64_t GetChannel (void);
+
 private:
 };
 
@@ -38,6 +38,7 @@
 #include "p1906-medium.h"
 #include "p1906-net-device.h"
 #include "p1906-motion.h"
+#include "p1906-interference.h"
 
 
 namespace ns3 {
@@ -56,6 +57,7 @@ P1906ReceiverCommunicationInterface::P1906ReceiverCommunicationInterface ()
   NS_LOG_FUNCTION (this);
   SetP1906NetDevice (0);
   m_specificity = 0;
+  m_interference = CreateObject<P1906Interference> ();
 }
 
 P1906ReceiverCommunicationInterface::~P1906ReceiverCommunicationInterface ()
@@ -63,6 +65,7 @@ P1906ReceiverCommunicationInterface::~P1906ReceiverCommunicationInterface ()
   NS_LOG_FUNCTION (this);
   SetP1906NetDevice (0);
   m_specificity = 0;
+  m_interference = 0;
 }
 
 void
@@ -102,6 +105,15 @@ P1906ReceiverCommunicationInterface::HandleReception (Ptr<P1906CommunicationInte
 	  //ignore the received message carrier
     }
 
+  // the carrier interferes with the next ones, whether received or not
+  m_interference->Add (message);
+}
+
+Ptr<P1906Interference>
+P1906ReceiverCommunicationInterface::GetP1906Interference (void)
+{
+  NS_LOG_FUNCTION (this);
+  return m_interference;
 }
 
 void
@@ -45,6 +45,7 @@ class P1906CommunicationInterface;
 class P1906Medium;
 class P1906NetDevice;
 class P1906Motion;
+class P1906Interference;
 
 /**
  * \ingroup P1906 framework
@@ -69,8 +70,18 @@ public:
   void SetP1906CommunicationInterface (Ptr<P1906CommunicationInterface> i);
   Ptr<P1906CommunicationInterface> GetP1906CommunicationInterface (void);
 
+  /**
+   * \brief evaluates the message carrier with the Specificity component,
+   * then adds it to the carriers active at this receiver, so that the
+   * Specificity sees those that arrived before it
+   */
   virtual void HandleReception (Ptr<P1906CommunicationInterface> src, Ptr<P1906CommunicationInterface> dst, Ptr<P1906MessageCarrier> message);
 
+  /**
+   * \returns the message carriers active at this receiver
+   */
+  Ptr<P1906Interference> GetP1906Interference (void);
+
   void SetP1906NetDevice (Ptr<P1906NetDevice> d);
   Ptr<P1906NetDevice> GetP1906NetDevice ();
 
@@ -82,6 +93,7 @@ private:
   Ptr<P1906CommunicationInterface> m_p1906CommunicationInterface;
   Ptr<P1906NetDevice> m_dev;
   Ptr<P1906Medium> m_medium;
+  Ptr<P1906Interference> m_interference;
 };
 
 }
@@ -0,0 +1,468 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+#include "ns3/log.h"
+#include "ns3/mobility-model.h"
+#include "ns3/callback.h"
+#include "ns3/node.h"
+
+#include "p1906-receiver-registry.h"
+#include "p1906-communication-interface.h"
+#include "p1906-net-device.h"
+#include "p1906-receiver-communication-interface.h"
+#include "p1906-specificity.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("P1906ReceiverRegistry");
+
+P1906ReceiverRegistry::P1906ReceiverRegistry ()
+  : m_built (false),
+    m_spatialIndexBuilt (false),
+    m_linkCache (false)
+{
+}
+
+P1906ReceiverRegistry::~P1906ReceiverRegistry ()
+{
+  Clear ();
+}
+
+void
+P1906ReceiverRegistry::Build (const P1906CommunicationInterfaces &interfaces)
+{
+  NS_LOG_FUNCTION (this << interfaces.size ());
+  Clear ();
+
+  uint32_t n = interfaces.size ();
+  m_interfaces.resize (n);
+  m_mobilities.resize (n, 0);
+  m_x.resize (n, 0.);
+  m_y.resize (n, 0.);
+  m_z.resize (n, 0.);
+  m_moving.resize (n, false);
+  m_channels.resize (n, 0);
+
+  for (uint32_t id = 0; id < n; id++)
+    {
+      m_interfaces[id] = PeekPointer (interfaces[id]);
+      m_idsByInterface[m_interfaces[id]] = id;
+
+      Ptr<P1906ReceiverCommunicationInterface> rx = interfaces[id]->GetP1906ReceiverCommunicationInterface ();
+      if (rx && rx->GetP1906Specificity ())
+        {
+          m_channels[id] = rx->GetP1906Specificity ()->GetChannel ();
+        }
+      m_idsByChannel[m_channels[id]].push_back (id);
+
+      Ptr<MobilityModel> mobility = interfaces[id]->GetP1906NetDevice ()->GetNode ()->GetObject<MobilityModel> ();
+      if (!mobility)
+        {
+          m_unlocatedIds.push_back (id);
+          continue;
+        }
+      m_mobilities[id] = PeekPointer (mobility);
+      if (m_idsByMobility.find (PeekPointer (mobility)) == m_idsByMobility.end ())
+        {
+          mobility->TraceConnectWithoutContext ("CourseChange",
+                MakeCallback (&P1906ReceiverRegistry::HandleCourseChange, this));
+          m_connected.push_back (mobility);
+        }
+      m_idsByMobility[PeekPointer (mobility)].push_back (id);
+
+      Vector velocity = mobility->GetVelocity ();
+      Update (id, mobility->GetPosition (), velocity.x != 0. || velocity.y != 0. || velocity.z != 0.);
+    }
+
+  m_built = true;
+}
+
+void
+P1906ReceiverRegistry::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector< Ptr<MobilityModel> >::iterator it = m_connected.begin (); it != m_connected.end (); it++)
+    {
+      (*it)->TraceDisconnectWithoutContext ("CourseChange",
+            MakeCallback (&P1906ReceiverRegistry::HandleCourseChange, this));
+    }
+  m_connected.clear ();
+  m_idsByMobility.clear ();
+  m_interfaces.clear ();
+  m_mobilities.clear ();
+  m_x.clear ();
+  m_y.clear ();
+  m_z.clear ();
+  m_moving.clear ();
+  m_channels.clear ();
+  m_idsByChannel.clear ();
+  m_movingIds.clear ();
+  m_unlocatedIds.clear ();
+  m_spatialIndex.Clear ();
+  m_spatialIndexBuilt = false;
+  m_idsByInterface.clear ();
+  m_links.clear ();
+  m_built = false;
+}
+
+bool
+P1906ReceiverRegistry::IsBuilt (void) const
+{
+  return m_built;
+}
+
+uint32_t
+P1906ReceiverRegistry::GetN (void) const
+{
+  return m_interfaces.size ();
+}
+
+P1906CommunicationInterface*
+P1906ReceiverRegistry::GetCommunicationInterface (uint32_t id) const
+{
+  return m_interfaces[id];
+}
+
+uint32_t
+P1906ReceiverRegistry::GetNUnlocated (void) const
+{
+  return m_unlocatedIds.size ();
+}
+
+uint64_t
+P1906ReceiverRegistry::GetChannel (uint32_t id) const
+{
+  return m_channels[id];
+}
+
+bool
+P1906ReceiverRegistry::Accepts (uint32_t id, uint64_t channel) const
+{
+  return channel == 0 || m_channels[id] == 0 || m_channels[id] == channel;
+}
+
+void
+P1906ReceiverRegistry::GetReceivers (uint64_t channel, std::vector<uint32_t> &ids) const
+{
+  ids.clear ();
+  if (channel == 0)
+    {
+      ids.resize (m_interfaces.size ());
+      for (uint32_t id = 0; id < ids.size (); id++)
+        {
+          ids[id] = id;
+        }
+      return;
+    }
+
+  // the receivers on the channel, merged with those on any channel
+  static const std::vector<uint32_t> none;
+  std::map<uint64_t, std::vector<uint32_t> >::const_iterator same = m_idsByChannel.find (channel);
+  std::map<uint64_t, std::vector<uint32_t> >::const_iterator any = m_idsByChannel.find (0);
+  const std::vector<uint32_t> &a = (same == m_idsByChannel.end ()) ? none : same->second;
+  const std::vector<uint32_t> &b = (any == m_idsByChannel.end ()) ? none : any->second;
+  ids.resize (a.size () + b.size ());
+  std::merge (a.begin (), a.end (), b.begin (), b.end (), ids.begin ());
+}
+
+void
+P1906ReceiverRegistry::Update (uint32_t id, const Vector &position, bool moving)
+{
+  m_x[id] = position.x;
+  m_y[id] = position.y;
+  m_z[id] = position.z;
+
+  if (moving != m_moving[id])
+    {
+      m_moving[id] = moving;
+      if (moving)
+        {
+          m_movingIds.insert (std::upper_bound (m_movingIds.begin (), m_movingIds.end (), id), id);
+        }
+      else
+        {
+          m_movingIds.erase (std::lower_bound (m_movingIds.begin (), m_movingIds.end (), id));
+        }
+    }
+
+  // the moving receivers are checked one by one, see Query
+  if (m_spatialIndexBuilt)
+    {
+      if (moving)
+        {
+          m_spatialIndex.Remove (id);
+        }
+      else
+        {
+          m_spatialIndex.Update (id, position);
+        }
+    }
+}
+
+void
+P1906ReceiverRegistry::HandleCourseChange (Ptr<const MobilityModel> mobility)
+{
+  NS_LOG_FUNCTION (this);
+  std::map<const MobilityModel*, std::vector<uint32_t> >::iterator it = m_idsByMobility.find (PeekPointer (mobility));
+  if (it == m_idsByMobility.end ())
+    {
+      return;
+    }
+  Vector position = mobility->GetPosition ();
+  Vector velocity = mobility->GetVelocity ();
+  bool moving = velocity.x != 0. || velocity.y != 0. || velocity.z != 0.;
+  for (std::vector<uint32_t>::iterator id = it->second.begin (); id != it->second.end (); id++)
+    {
+      Update (*id, position, moving);
+      UpdateLinks (*id);
+    }
+}
+
+void
+P1906ReceiverRegistry::Refresh (void)
+{
+  for (std::vector<uint32_t>::iterator id = m_movingIds.begin (); id != m_movingIds.end (); id++)
+    {
+      Vector position = m_mobilities[*id]->GetPosition ();
+      m_x[*id] = position.x;
+      m_y[*id] = position.y;
+      m_z[*id] = position.z;
+    }
+}
+
+void
+P1906ReceiverRegistry::GetDistances (const Vector &position, const std::vector<uint32_t> &ids, std::vector<double> &distances) const
+{
+  uint32_t n = ids.size ();
+  distances.resize (n);
+  const double *x = m_x.empty () ? 0 : &m_x[0];
+  const double *y = m_y.empty () ? 0 : &m_y[0];
+  const double *z = m_z.empty () ? 0 : &m_z[0];
+  for (uint32_t i = 0; i < n; i++)
+    {
+      // same operands and order as CalculateDistance (receiver, transmitter)
+      uint32_t id = ids[i];
+      double dx = position.x - x[id];
+      double dy = position.y - y[id];
+      double dz = position.z - z[id];
+      distances[i] = std::sqrt (dx * dx + dy * dy + dz * dz);
+    }
+}
+
+void
+P1906ReceiverRegistry::SetCellSize (double size)
+{
+  NS_LOG_FUNCTION (this << size);
+  m_spatialIndex.SetCellSize (size);
+  for (uint32_t id = 0; id < m_interfaces.size (); id++)
+    {
+      if (m_mobilities[id] && !m_moving[id])
+        {
+          m_spatialIndex.Update (id, Vector (m_x[id], m_y[id], m_z[id]));
+        }
+    }
+  m_spatialIndexBuilt = true;
+}
+
+double
+P1906ReceiverRegistry::GetCellSize (void) const
+{
+  return m_spatialIndex.GetCellSize ();
+}
+
+bool
+P1906ReceiverRegistry::HasSpatialIndex (void) const
+{
+  return m_spatialIndexBuilt;
+}
+
+void
+P1906ReceiverRegistry::Query (const Vector &position, double radius, std::vector<uint32_t> &ids)
+{
+  NS_LOG_FUNCTION (this << position << radius);
+  NS_ASSERT (m_spatialIndexBuilt);
+  m_spatialIndex.Query (position, radius, ids);
+
+  double radius2 = radius * radius;
+  bool merge = !m_unlocatedIds.empty ();
+  for (std::vector<uint32_t>::iterator id = m_movingIds.begin (); id != m_movingIds.end (); id++)
+    {
+      double dx = position.x - m_x[*id];
+      double dy = position.y - m_y[*id];
+      double dz = position.z - m_z[*id];
+      if (dx * dx + dy * dy + dz * dz <= radius2)
+        {
+          ids.push_back (*id);
+          merge = true;
+        }
+    }
+  if (merge)
+    {
+      ids.insert (ids.end (), m_unlocatedIds.begin (), m_unlocatedIds.end ());
+      std::sort (ids.begin (), ids.end ());
+    }
+}
+
+void
+P1906ReceiverRegistry::SetLinkCache (bool enabled)
+{
+  NS_LOG_FUNCTION (this << enabled);
+  m_linkCache = enabled;
+  m_links.clear ();
+}
+
+bool
+P1906ReceiverRegistry::IsLinkCacheUsable (void) const
+{
+  return m_linkCache && m_built && m_movingIds.empty () && m_unlocatedIds.empty ();
+}
+
+bool
+P1906ReceiverRegistry::FindId (const P1906CommunicationInterface *i, uint32_t &id) const
+{
+  std::map<const P1906CommunicationInterface*, uint32_t>::const_iterator it = m_idsByInterface.find (i);
+  if (it == m_idsByInterface.end ())
+    {
+      return false;
+    }
+  id = it->second;
+  return true;
+}
+
+const P1906ReceiverRegistry::LinkRow &
+P1906ReceiverRegistry::GetLinks (uint32_t src, double radius, uint64_t channel)
+{
+  if (m_links.size () != m_interfaces.size ())
+    {
+      LinkRow empty;
+      empty.m_valid = false;
+      empty.m_radius = 0.;
+      empty.m_channel = 0;
+      m_links.assign (m_interfaces.size (), empty);
+    }
+  const LinkRow &row = m_links[src];
+  if (!row.m_valid || row.m_radius != radius || row.m_channel != channel)
+    {
+      NS_LOG_FUNCTION (this << "build the links of" << src << radius << channel);
+      BuildLinks (src, radius, channel);
+    }
+  return row;
+}
+
+void
+P1906ReceiverRegistry::BuildLinks (uint32_t src, double radius, uint64_t channel)
+{
+  // no logging: this runs on the worker threads of the medium
+  LinkRow &row = m_links[src];
+  Vector position (m_x[src], m_y[src], m_z[src]);
+  if (m_spatialIndexBuilt && radius < std::numeric_limits<double>::infinity ())
+    {
+      m_spatialIndex.Query (position, radius, row.m_ids);
+      row.m_ids.erase (std::remove (row.m_ids.begin (), row.m_ids.end (), src), row.m_ids.end ());
+    }
+  else
+    {
+      GetReceivers (channel, row.m_ids);
+      row.m_ids.erase (std::remove (row.m_ids.begin (), row.m_ids.end (), src), row.m_ids.end ());
+    }
+
+  // keep the receivers on the channel and within radius, as the spatial
+  // index may be missing
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < row.m_ids.size (); i++)
+    {
+      if (Accepts (row.m_ids[i], channel) && IsWithin (src, row.m_ids[i], radius))
+        {
+          row.m_ids[kept++] = row.m_ids[i];
+        }
+    }
+  row.m_ids.resize (kept);
+  GetDistances (position, row.m_ids, row.m_distances);
+  row.m_radius = radius;
+  row.m_channel = channel;
+  row.m_valid = true;
+}
+
+bool
+P1906ReceiverRegistry::IsWithin (uint32_t src, uint32_t id, double radius) const
+{
+  // the test of P1906SpatialIndex::Query, so that cached rows match the queries
+  double dx = m_x[id] - m_x[src];
+  double dy = m_y[id] - m_y[src];
+  double dz = m_z[id] - m_z[src];
+  return dx * dx + dy * dy + dz * dz <= radius * radius;
+}
+
+void
+P1906ReceiverRegistry::UpdateLinks (uint32_t id)
+{
+  NS_LOG_FUNCTION (this << id);
+  if (m_links.empty ())
+    {
+      return;
+    }
+  m_links[id].m_valid = false;
+
+  // the entry of id in the rows of the other transmitters
+  std::vector<uint32_t> column (1, id);
+  std::vector<double> distance;
+  for (uint32_t src = 0; src < m_links.size (); src++)
+    {
+      LinkRow &row = m_links[src];
+      if (!row.m_valid || src == id)
+        {
+          continue;
+        }
+      GetDistances (Vector (m_x[src], m_y[src], m_z[src]), column, distance);
+      std::vector<uint32_t>::iterator it = std::lower_bound (row.m_ids.begin (), row.m_ids.end (), id);
+      uint32_t i = it - row.m_ids.begin ();
+      bool present = (it != row.m_ids.end () && *it == id);
+      if (Accepts (id, row.m_channel) && IsWithin (src, id, row.m_radius))
+        {
+          if (!present)
+            {
+              row.m_ids.insert (it, id);
+              row.m_distances.insert (row.m_distances.begin () + i, distance[0]);
+            }
+          else
+            {
+              row.m_distances[i] = distance[0];
+            }
+        }
+      else if (present)
+        {
+          row.m_ids.erase (it);
+          row.m_distances.erase (row.m_distances.begin () + i);
+        }
+    }
+}
+
+} // namespace ns3
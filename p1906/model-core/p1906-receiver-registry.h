@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+
+#ifndef P1906_RECEIVER_REGISTRY
+#define P1906_RECEIVER_REGISTRY
+
+#include "ns3/ptr.h"
+#include "ns3/vector.h"
+#include "ns3/p1906-spatial-index.h"
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+class P1906CommunicationInterface;
+class MobilityModel;
+
+/**
+ * \ingroup P1906 framework
+ *
+ * \class P1906ReceiverRegistry
+ *
+ * \brief Packed view of the communication interfaces attached to a
+ * P1906Medium: raw interface and MobilityModel pointers and positions in
+ * separate x/y/z arrays, indexed like the interfaces. Positions are
+ * refreshed through the CourseChange trace of the mobility models; those
+ * of the receivers that were moving at their last course change are read
+ * again by Refresh. The receivers are also grouped by the channel of
+ * their Specificity, read when the registry is built.
+ */
+
+class P1906ReceiverRegistry
+{
+public:
+  typedef std::vector< Ptr<P1906CommunicationInterface> > P1906CommunicationInterfaces;
+
+  P1906ReceiverRegistry ();
+  ~P1906ReceiverRegistry ();
+
+  void Build (const P1906CommunicationInterfaces &interfaces);
+  void Clear (void);
+  bool IsBuilt (void) const;
+
+  uint32_t GetN (void) const;
+  P1906CommunicationInterface* GetCommunicationInterface (uint32_t id) const;
+  /**
+   * \returns the number of interfaces whose node has no MobilityModel
+   */
+  uint32_t GetNUnlocated (void) const;
+
+  /**
+   * \returns the channel of the Specificity of the receiver, 0 for any
+   */
+  uint64_t GetChannel (uint32_t id) const;
+  /**
+   * \returns whether the receiver may accept carriers on channel (0 for a
+   * transmitter that may reach any channel)
+   */
+  bool Accepts (uint32_t id, uint64_t channel) const;
+  /**
+   * \param ids filled, in increasing order, with the receivers that may
+   * accept carriers on channel
+   */
+  void GetReceivers (uint64_t channel, std::vector<uint32_t> &ids) const;
+
+  /**
+   * \brief reads the current position of the moving receivers
+   */
+  void Refresh (void);
+
+  /**
+   * \param position the position of the transmitter
+   * \param ids located receivers
+   * \param distances filled with the distance between position and each
+   * receiver, computed as MobilityModel::GetDistanceFrom does
+   */
+  void GetDistances (const Vector &position, const std::vector<uint32_t> &ids, std::vector<double> &distances) const;
+
+  /**
+   * \param size the cell side [m] of the spatial index used by Query
+   */
+  void SetCellSize (double size);
+  double GetCellSize (void) const;
+  bool HasSpatialIndex (void) const;
+
+  /**
+   * \param ids filled, in increasing order, with the receivers within
+   * radius of position and those that have no MobilityModel
+   */
+  void Query (const Vector &position, double radius, std::vector<uint32_t> &ids);
+
+  /// the receivers of a transmitter, as cached by the link cache
+  struct LinkRow
+  {
+    bool m_valid;
+    double m_radius;
+    uint64_t m_channel;
+    std::vector<uint32_t> m_ids;
+    std::vector<double> m_distances;
+  };
+
+  /**
+   * \param enabled whether to cache, for each transmitter, the receivers
+   * within its radius and their distances. A course change of a receiver
+   * drops its row and updates its entry in every other row.
+   */
+  void SetLinkCache (bool enabled);
+  /**
+   * \returns whether the link cache is enabled and describes the topology,
+   * i.e., no receiver is moving or without MobilityModel
+   */
+  bool IsLinkCacheUsable (void) const;
+  bool FindId (const P1906CommunicationInterface *i, uint32_t &id) const;
+
+  /**
+   * \returns the row of src for radius (infinity for every receiver) and
+   * channel, built if needed. The spatial index is used when it exists.
+   */
+  const LinkRow &GetLinks (uint32_t src, double radius, uint64_t channel);
+  /**
+   * \brief builds the row of src; calls for distinct transmitters may run
+   * concurrently
+   */
+  void BuildLinks (uint32_t src, double radius, uint64_t channel);
+
+private:
+  bool IsWithin (uint32_t src, uint32_t id, double radius) const;
+  void UpdateLinks (uint32_t id);
+  void Update (uint32_t id, const Vector &position, bool moving);
+  void HandleCourseChange (Ptr<const MobilityModel> mobility);
+
+  bool m_built;
+  std::vector<P1906CommunicationInterface*> m_interfaces;
+  std::vector<MobilityModel*> m_mobilities;
+  std::vector<double> m_x;
+  std::vector<double> m_y;
+  std::vector<double> m_z;
+  std::vector<bool> m_moving;
+  std::vector<uint64_t> m_channels;
+  std::map<uint64_t, std::vector<uint32_t> > m_idsByChannel;
+  std::vector<uint32_t> m_movingIds;
+  std::vector<uint32_t> m_unlocatedIds;
+  std::map<const MobilityModel*, std::vector<uint32_t> > m_idsByMobility;
+  std::vector< Ptr<MobilityModel> > m_connected;
+
+  bool m_spatialIndexBuilt;
+  P1906SpatialIndex m_spatialIndex;
+
+  bool m_linkCache;
+  std::map<const P1906CommunicationInterface*, uint32_t> m_idsByInterface;
+  std::vector<LinkRow> m_links;
+};
+
+}
+
+#endif /* P1906_RECEIVER_REGISTRY */
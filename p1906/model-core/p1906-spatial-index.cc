@@ -0,0 +1,183 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+#include "ns3/log.h"
+
+#include "p1906-spatial-index.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("P1906SpatialIndex");
+
+bool
+P1906SpatialIndex::Cell::operator< (const Cell &o) const
+{
+  if (x != o.x)
+    {
+      return x < o.x;
+    }
+  if (y != o.y)
+    {
+      return y < o.y;
+    }
+  return z < o.z;
+}
+
+P1906SpatialIndex::P1906SpatialIndex ()
+  : m_cellSize (1.)
+{
+}
+
+void
+P1906SpatialIndex::SetCellSize (double size)
+{
+  NS_LOG_FUNCTION (this << size);
+  NS_ASSERT (size > 0.);
+  m_cellSize = size;
+  Clear ();
+}
+
+double
+P1906SpatialIndex::GetCellSize (void) const
+{
+  return m_cellSize;
+}
+
+void
+P1906SpatialIndex::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_cells.clear ();
+  m_positions.clear ();
+  m_entryCells.clear ();
+  m_indexed.clear ();
+}
+
+P1906SpatialIndex::Cell
+P1906SpatialIndex::GetCell (const Vector &position) const
+{
+  Cell c;
+  c.x = static_cast<int64_t> (std::floor (position.x / m_cellSize));
+  c.y = static_cast<int64_t> (std::floor (position.y / m_cellSize));
+  c.z = static_cast<int64_t> (std::floor (position.z / m_cellSize));
+  return c;
+}
+
+void
+P1906SpatialIndex::Update (uint32_t id, const Vector &position)
+{
+  NS_LOG_FUNCTION (this << id << position);
+  if (id >= m_indexed.size ())
+    {
+      m_positions.resize (id + 1);
+      m_entryCells.resize (id + 1);
+      m_indexed.resize (id + 1, false);
+    }
+
+  Cell cell = GetCell (position);
+  m_positions[id] = position;
+  if (m_indexed[id])
+    {
+      const Cell &old = m_entryCells[id];
+      if (!(old < cell) && !(cell < old))
+        {
+          return;
+        }
+      Remove (id);
+      m_positions[id] = position;
+    }
+
+  m_cells[cell].push_back (id);
+  m_entryCells[id] = cell;
+  m_indexed[id] = true;
+}
+
+void
+P1906SpatialIndex::Remove (uint32_t id)
+{
+  NS_LOG_FUNCTION (this << id);
+  if (!Contains (id))
+    {
+      return;
+    }
+  std::map<Cell, std::vector<uint32_t> >::iterator it = m_cells.find (m_entryCells[id]);
+  std::vector<uint32_t> &ids = it->second;
+  ids.erase (std::find (ids.begin (), ids.end (), id));
+  if (ids.empty ())
+    {
+      m_cells.erase (it);
+    }
+  m_indexed[id] = false;
+}
+
+bool
+P1906SpatialIndex::Contains (uint32_t id) const
+{
+  return id < m_indexed.size () && m_indexed[id];
+}
+
+void
+P1906SpatialIndex::Query (const Vector &position, double radius, std::vector<uint32_t> &ids) const
+{
+  ids.clear ();
+  double radius2 = radius * radius;
+  int64_t reach = static_cast<int64_t> (std::ceil (radius / m_cellSize));
+  Cell center = GetCell (position);
+
+  Cell c;
+  for (c.x = center.x - reach; c.x <= center.x + reach; c.x++)
+    {
+      for (c.y = center.y - reach; c.y <= center.y + reach; c.y++)
+        {
+          for (c.z = center.z - reach; c.z <= center.z + reach; c.z++)
+            {
+              std::map<Cell, std::vector<uint32_t> >::const_iterator it = m_cells.find (c);
+              if (it == m_cells.end ())
+                {
+                  continue;
+                }
+              for (std::vector<uint32_t>::const_iterator id = it->second.begin (); id != it->second.end (); id++)
+                {
+                  const Vector &p = m_positions[*id];
+                  double dx = p.x - position.x;
+                  double dy = p.y - position.y;
+                  double dz = p.z - position.z;
+                  if (dx * dx + dy * dy + dz * dz <= radius2)
+                    {
+                      ids.push_back (*id);
+                    }
+                }
+            }
+        }
+    }
+  std::sort (ids.begin (), ids.end ());
+}
+
+} // namespace ns3
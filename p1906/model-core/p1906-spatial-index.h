@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+
+#ifndef P1906_SPATIAL_INDEX
+#define P1906_SPATIAL_INDEX
+
+#include "ns3/vector.h"
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup P1906 framework
+ *
+ * \class P1906SpatialIndex
+ *
+ * \brief Uniform grid of cubic cells storing the positions of numbered
+ * entries (e.g., the communication interfaces attached to a medium), used
+ * to find the entries lying within a given radius without visiting all of
+ * them.
+ */
+
+class P1906SpatialIndex
+{
+public:
+  P1906SpatialIndex ();
+
+  /**
+   * \param size the side of a cell [m]; queries are cheapest when it is
+   * close to the radius they use. Changing it clears the index
+   */
+  void SetCellSize (double size);
+  double GetCellSize (void) const;
+
+  void Clear (void);
+
+  /**
+   * \brief adds the entry or, if already indexed, moves it to its new
+   * position
+   */
+  void Update (uint32_t id, const Vector &position);
+  void Remove (uint32_t id);
+  bool Contains (uint32_t id) const;
+
+  /**
+   * \param position the center of the query
+   * \param radius the query radius [m]
+   * \param ids filled with the entries within radius of position, in
+   * increasing order
+   *
+   * Query does not log, so that concurrent calls are safe.
+   */
+  void Query (const Vector &position, double radius, std::vector<uint32_t> &ids) const;
+
+private:
+  struct Cell
+  {
+    int64_t x;
+    int64_t y;
+    int64_t z;
+    bool operator< (const Cell &o) const;
+  };
+
+  Cell GetCell (const Vector &position) const;
+
+  double m_cellSize;
+  std::map<Cell, std::vector<uint32_t> > m_cells;
+  std::vector<Vector> m_positions;
+  std::vector<Cell> m_entryCells;
+  std::vector<bool> m_indexed;
+};
+
+}
+
+#endif /* P1906_SPATIAL_INDEX */
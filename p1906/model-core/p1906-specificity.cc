@@ -31,6 +31,10 @@
 #include "p1906-specificity.h"
 #include "p1906-motion.h"
 #include "p1906-communication-interface.h"
+#include "p1906-perturbation.h"
+#include "p1906-receiver-communication-interface.h"
+#include "p1906-interference.h"
+#include <limits>
 
 
 namespace ns3 {
@@ -61,6 +65,27 @@ P1906Specificity::CheckRxCompatibility (Ptr<P1906CommunicationInterface> src, Pt
   return true;
 }
 
+double
+P1906Specificity::GetMaxRange (Ptr<P1906Perturbation> perturbation)
+{
+  NS_LOG_FUNCTION (this << "Default behavior: unlimited range");
+  return std::numeric_limits<double>::infinity ();
+}
+
+uint64_t
+P1906Specificity::GetChannel (void)
+{
+  NS_LOG_FUNCTION (this << "Default behavior: any channel");
+  return 0;
+}
+
+bool
+P1906Specificity::UsesInterference (void)
+{
+  NS_LOG_FUNCTION (this << "Default behavior: no interference");
+  return false;
+}
+
 
 void
 P1906Specificity::SetP1906CommunicationInterface (Ptr<P1906CommunicationInterface> i)
@@ -75,4 +100,16 @@ P1906Specificity::GetP1906CommunicationInterface (void)
   NS_LOG_FUNCTION (this);
   return m_p1906CommunicationInterface;
 }
+
+Ptr<P1906Interference>
+P1906Specificity::GetP1906Interference (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_p1906CommunicationInterface ||
+      !m_p1906CommunicationInterface->GetP1906ReceiverCommunicationInterface ())
+    {
+      return 0;
+    }
+  return m_p1906CommunicationInterface->GetP1906ReceiverCommunicationInterface ()->GetP1906Interference ();
+}
 } // namespace ns3
@@ -39,6 +39,8 @@ namespace ns3 {
 class P1906MessageCarrier;
 class P1906Motion;
 class P1906CommunicationInterface;
+class P1906Perturbation;
+class P1906Interference;
 /**
  * \ingroup P1906 framework
  *
@@ -58,9 +60,39 @@ public:
 
   virtual bool CheckRxCompatibility (Ptr<P1906CommunicationInterface> src, Ptr<P1906CommunicationInterface> dst, Ptr<P1906MessageCarrier> message);
 
+  /**
+   * \param perturbation the Perturbation of the transmitter
+   * \returns the distance [m] beyond which CheckRxCompatibility rejects every
+   * message carrier produced by perturbation, or infinity if there is none.
+   * The default implementation accepts everything and returns infinity.
+   */
+  virtual double GetMaxRange (Ptr<P1906Perturbation> perturbation);
+
+  /**
+   * \returns the channel of the message carriers this Specificity may
+   * accept, or 0 (the default) for any channel. CheckRxCompatibility must
+   * reject the carriers of a Perturbation on another non-zero channel.
+   */
+  virtual uint64_t GetChannel (void);
+
+  /**
+   * \returns whether CheckRxCompatibility accounts for the message carriers
+   * active at the receiver (see GetP1906Interference), so that carriers it
+   * would reject still matter to the receiver. The default implementation
+   * returns false.
+   */
+  virtual bool UsesInterference (void);
+
   void SetP1906CommunicationInterface (Ptr<P1906CommunicationInterface> i);
   Ptr<P1906CommunicationInterface> GetP1906CommunicationInterface (void);
 
+  /**
+   * \returns the message carriers active at the receiver of this
+   * Specificity, which does not include the one under evaluation yet, or 0
+   * if there is no receiver
+   */
+  Ptr<P1906Interference> GetP1906Interference (void);
+
 private:
   Ptr<P1906CommunicationInterface> m_p1906CommunicationInterface;
 };
@@ -0,0 +1,146 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+#include "ns3/log.h"
+
+#include "p1906-worker-pool.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("P1906WorkerPool");
+
+P1906WorkerPool::P1906WorkerPool ()
+  : m_nThreads (1),
+    m_generation (0),
+    m_running (0),
+    m_stop (false),
+    m_job (0),
+    m_n (0)
+{
+}
+
+P1906WorkerPool::~P1906WorkerPool ()
+{
+  Stop ();
+}
+
+void
+P1906WorkerPool::SetNThreads (uint32_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+  Stop ();
+  m_nThreads = (n == 0) ? 1 : n;
+  m_stop = false;
+  for (uint32_t t = 1; t < m_nThreads; t++)
+    {
+      m_threads.push_back (std::thread (&P1906WorkerPool::Work, this, t, m_generation));
+    }
+}
+
+uint32_t
+P1906WorkerPool::GetNThreads (void) const
+{
+  return m_nThreads;
+}
+
+void
+P1906WorkerPool::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_stop = true;
+  }
+  m_started.notify_all ();
+  for (std::vector<std::thread>::iterator it = m_threads.begin (); it != m_threads.end (); it++)
+    {
+      it->join ();
+    }
+  m_threads.clear ();
+  m_nThreads = 1;
+}
+
+void
+P1906WorkerPool::Run (uint32_t n, const Job &job)
+{
+  if (m_threads.empty () || n < m_nThreads)
+    {
+      job (0, n);
+      return;
+    }
+
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_job = &job;
+    m_n = n;
+    m_running = m_threads.size ();
+    m_generation++;
+  }
+  m_started.notify_all ();
+
+  job (0, n / m_nThreads);
+
+  std::unique_lock<std::mutex> lock (m_mutex);
+  while (m_running > 0)
+    {
+      m_finished.wait (lock);
+    }
+  m_job = 0;
+}
+
+void
+P1906WorkerPool::Work (uint32_t thread, uint64_t generation)
+{
+  // no logging here: the log sinks are not thread-safe
+  std::unique_lock<std::mutex> lock (m_mutex);
+  while (true)
+    {
+      while (!m_stop && m_generation == generation)
+        {
+          m_started.wait (lock);
+        }
+      if (m_stop)
+        {
+          return;
+        }
+      generation = m_generation;
+      const Job *job = m_job;
+      uint64_t n = m_n;
+      lock.unlock ();
+
+      (*job) (n * thread / m_nThreads, n * (thread + 1) / m_nThreads);
+
+      lock.lock ();
+      if (--m_running == 0)
+        {
+          m_finished.notify_one ();
+        }
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,94 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+
+#ifndef P1906_WORKER_POOL
+#define P1906_WORKER_POOL
+
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace ns3 {
+
+/**
+ * \ingroup P1906 framework
+ *
+ * \class P1906WorkerPool
+ *
+ * \brief Set of persistent threads splitting a loop over [0, n) in
+ * contiguous chunks. The calling thread processes the first chunk and
+ * Run returns when all of them are done, so the work is never left
+ * running across simulator events.
+ */
+
+class P1906WorkerPool
+{
+public:
+  typedef std::function<void (uint32_t begin, uint32_t end)> Job;
+
+  P1906WorkerPool ();
+  ~P1906WorkerPool ();
+
+  /**
+   * \param n the number of threads running a job, including the calling
+   * one; 0 and 1 run every job on the calling thread
+   */
+  void SetNThreads (uint32_t n);
+  uint32_t GetNThreads (void) const;
+
+  /**
+   * \brief calls job on disjoint chunks covering [0, n), concurrently
+   */
+  void Run (uint32_t n, const Job &job);
+
+private:
+  P1906WorkerPool (const P1906WorkerPool &);
+  P1906WorkerPool &operator= (const P1906WorkerPool &);
+
+  void Stop (void);
+  void Work (uint32_t thread, uint64_t generation);
+
+  uint32_t m_nThreads;
+  std::vector<std::thread> m_threads;
+  std::mutex m_mutex;
+  std::condition_variable m_started;
+  std::condition_variable m_finished;
+  uint64_t m_generation;
+  uint32_t m_running;
+  bool m_stop;
+  const Job *m_job;
+  uint32_t m_n;
+};
+
+}
+
+#endif /* P1906_WORKER_POOL */
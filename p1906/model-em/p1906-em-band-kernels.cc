@@ -0,0 +1,520 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+#include "p1906-em-band-kernels.h"
+#include <cmath>
+
+#if defined (__AVX__)
+#include <immintrin.h>
+#elif defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ns3 {
+
+namespace {
+
+/*
+ * e^x = 2^k * e^r, with k = round (x / ln 2) and |r| <= ln 2 / 2. k is
+ * rounded by adding 1.5 * 2^52, which leaves it in the low bits of the sum,
+ * ln 2 is split in two parts so that k * ln 2 is exact, and e^r is its
+ * Taylor polynomial of degree 13, whose truncation error is below 1e-17.
+ */
+const double g_expLog2e = 1.4426950408889634;
+const double g_expLn2Hi = 6.93147180369123816490e-01;
+const double g_expLn2Lo = 1.90821492927058770002e-10;
+const double g_expRound = 6755399441055744.0;
+const double g_expMin = -708.39641853226408;
+const double g_expMax = 709.;
+const double g_expCoefficients[] = {
+  1. / 6227020800., 1. / 479001600., 1. / 39916800., 1. / 3628800., 1. / 362880.,
+  1. / 40320., 1. / 5040., 1. / 720., 1. / 120., 1. / 24., 1. / 6., 1. / 2., 1., 1.
+};
+const uint32_t g_expNCoefficients = sizeof (g_expCoefficients) / sizeof (g_expCoefficients[0]);
+
+double
+ExpScalar (double x)
+{
+  // std::exp, with the flush and the clamp of the vectorized forms
+  if (!(x >= g_expMin))
+    {
+      return 0.;
+    }
+  return std::exp (x < g_expMax ? x : g_expMax);
+}
+
+/*
+ * log2 (y) = e + ln (m) / ln 2, with y = 2^e * m and m in [sqrt (1/2),
+ * sqrt (2)). e and m are split from the bits of y, and ln (m) = 2 atanh (s)
+ * with s = (m - 1) / (m + 1), i.e., |s| < 0.172, whose odd series converges
+ * below 1e-17 with 11 terms. FAST keeps the first 3 terms.
+ */
+const double g_logCoefficients[] = {
+  2. / 21., 2. / 19., 2. / 17., 2. / 15., 2. / 13., 2. / 11., 2. / 9., 2. / 7., 2. / 5., 2. / 3., 2.
+};
+const uint32_t g_logNCoefficients = sizeof (g_logCoefficients) / sizeof (g_logCoefficients[0]);
+const uint32_t g_logNFastCoefficients = 3;
+const double g_logSqrt2 = 1.4142135623730951;
+const double g_logExponentBias = 4503599627370496. + 1023.;
+const uint64_t g_logMantissaMask = 0x000fffffffffffffULL;
+const uint64_t g_logOne = 0x3ff0000000000000ULL;
+const uint64_t g_logExponentMagic = 0x4330000000000000ULL;
+
+#if defined (__AVX2__)
+template <uint32_t first>
+inline __m256d
+Log2OnePlus256 (__m256d x)
+{
+  __m256d y = _mm256_add_pd (_mm256_set1_pd (1.), x);
+  __m256i bits = _mm256_castpd_si256 (y);
+  // 2^52 + the biased exponent, read as a double
+  __m256d e = _mm256_castsi256_pd (_mm256_or_si256 (_mm256_srli_epi64 (bits, 52),
+                                                    _mm256_set1_epi64x (g_logExponentMagic)));
+  e = _mm256_sub_pd (e, _mm256_set1_pd (g_logExponentBias));
+  __m256d m = _mm256_castsi256_pd (_mm256_or_si256 (_mm256_and_si256 (bits, _mm256_set1_epi64x (g_logMantissaMask)),
+                                                    _mm256_set1_epi64x (g_logOne)));
+  __m256d large = _mm256_cmp_pd (m, _mm256_set1_pd (g_logSqrt2), _CMP_GT_OQ);
+  m = _mm256_blendv_pd (m, _mm256_mul_pd (m, _mm256_set1_pd (0.5)), large);
+  e = _mm256_add_pd (e, _mm256_and_pd (large, _mm256_set1_pd (1.)));
+  __m256d s = _mm256_div_pd (_mm256_sub_pd (m, _mm256_set1_pd (1.)), _mm256_add_pd (m, _mm256_set1_pd (1.)));
+  __m256d z = _mm256_mul_pd (s, s);
+  __m256d z2 = _mm256_mul_pd (z, z);
+  // the even and the odd powers of z as two independent chains in z^2
+  __m256d even = _mm256_setzero_pd ();
+  __m256d odd = _mm256_setzero_pd ();
+  for (uint32_t j = first; j < g_logNCoefficients; j++)
+    {
+      if ((g_logNCoefficients - 1 - j) % 2 == 0)
+        {
+          even = _mm256_add_pd (_mm256_mul_pd (even, z2), _mm256_set1_pd (g_logCoefficients[j]));
+        }
+      else
+        {
+          odd = _mm256_add_pd (_mm256_mul_pd (odd, z2), _mm256_set1_pd (g_logCoefficients[j]));
+        }
+    }
+  __m256d p = _mm256_add_pd (even, _mm256_mul_pd (z, odd));
+  return _mm256_add_pd (e, _mm256_mul_pd (_mm256_mul_pd (s, p), _mm256_set1_pd (g_expLog2e)));
+}
+#endif
+
+#if defined (__SSE2__)
+template <uint32_t first>
+inline __m128d
+Log2OnePlus128 (__m128d x)
+{
+  __m128d y = _mm_add_pd (_mm_set1_pd (1.), x);
+  __m128i bits = _mm_castpd_si128 (y);
+  // 2^52 + the biased exponent, read as a double
+  __m128d e = _mm_castsi128_pd (_mm_or_si128 (_mm_srli_epi64 (bits, 52),
+                                              _mm_set1_epi64x (g_logExponentMagic)));
+  e = _mm_sub_pd (e, _mm_set1_pd (g_logExponentBias));
+  __m128d m = _mm_castsi128_pd (_mm_or_si128 (_mm_and_si128 (bits, _mm_set1_epi64x (g_logMantissaMask)),
+                                              _mm_set1_epi64x (g_logOne)));
+  __m128d large = _mm_cmpgt_pd (m, _mm_set1_pd (g_logSqrt2));
+  m = _mm_or_pd (_mm_and_pd (large, _mm_mul_pd (m, _mm_set1_pd (0.5))), _mm_andnot_pd (large, m));
+  e = _mm_add_pd (e, _mm_and_pd (large, _mm_set1_pd (1.)));
+  __m128d s = _mm_div_pd (_mm_sub_pd (m, _mm_set1_pd (1.)), _mm_add_pd (m, _mm_set1_pd (1.)));
+  __m128d z = _mm_mul_pd (s, s);
+  __m128d z2 = _mm_mul_pd (z, z);
+  // the even and the odd powers of z as two independent chains in z^2
+  __m128d even = _mm_setzero_pd ();
+  __m128d odd = _mm_setzero_pd ();
+  for (uint32_t j = first; j < g_logNCoefficients; j++)
+    {
+      if ((g_logNCoefficients - 1 - j) % 2 == 0)
+        {
+          even = _mm_add_pd (_mm_mul_pd (even, z2), _mm_set1_pd (g_logCoefficients[j]));
+        }
+      else
+        {
+          odd = _mm_add_pd (_mm_mul_pd (odd, z2), _mm_set1_pd (g_logCoefficients[j]));
+        }
+    }
+  __m128d p = _mm_add_pd (even, _mm_mul_pd (z, odd));
+  return _mm_add_pd (e, _mm_mul_pd (_mm_mul_pd (s, p), _mm_set1_pd (g_expLog2e)));
+}
+#endif
+
+const uint32_t g_logFirstFast = g_logNCoefficients - g_logNFastCoefficients;
+
+// the kernels below use nBands sub-bands if it is not 0, and n otherwise
+
+template <uint32_t nBands, uint32_t first>
+void
+Log2OnePlusTerms (const double *x, double *out, uint32_t n)
+{
+  if (nBands > 0)
+    {
+      n = nBands;
+    }
+  uint32_t i = 0;
+#if defined (__AVX2__)
+  for (; i + 4 <= n; i += 4)
+    {
+      _mm256_storeu_pd (out + i, Log2OnePlus256<first> (_mm256_loadu_pd (x + i)));
+    }
+#endif
+#if defined (__SSE2__)
+  // with two lanes, the EXACT polynomial is slower than std::log2
+  for (; first > 0 && i + 2 <= n; i += 2)
+    {
+      _mm_storeu_pd (out + i, Log2OnePlus128<first> (_mm_loadu_pd (x + i)));
+    }
+#endif
+  for (; i < n; i++)
+    {
+      out[i] = std::log2 (1. + x[i]);
+    }
+}
+
+template <uint32_t nBands, uint32_t first>
+double
+SumLog2OnePlusRatioTerms (const double *a, const double *b, uint32_t n, double limit)
+{
+  if (nBands > 0)
+    {
+      n = nBands;
+    }
+  double sum = 0.;
+  uint32_t i = 0;
+  double lanes[4];
+#if defined (__AVX2__)
+  for (; i + 4 <= n && sum < limit; i += 4)
+    {
+      __m256d ratio = _mm256_div_pd (_mm256_loadu_pd (a + i), _mm256_loadu_pd (b + i));
+      _mm256_storeu_pd (lanes, Log2OnePlus256<first> (ratio));
+      sum += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+#endif
+#if defined (__SSE2__)
+  for (; first > 0 && i + 2 <= n && sum < limit; i += 2)
+    {
+      __m128d ratio = _mm_div_pd (_mm_loadu_pd (a + i), _mm_loadu_pd (b + i));
+      _mm_storeu_pd (lanes, Log2OnePlus128<first> (ratio));
+      sum += lanes[0] + lanes[1];
+    }
+#endif
+  for (; i < n && sum < limit; i++)
+    {
+      sum += std::log2 (1. + a[i] / b[i]);
+    }
+  return sum;
+}
+
+template <uint32_t nBands>
+void
+MultiplyBands (const double *a, const double *b, double *out, uint32_t n)
+{
+  if (nBands > 0)
+    {
+      n = nBands;
+    }
+  uint32_t i = 0;
+#if defined (__AVX__)
+  for (; i + 4 <= n; i += 4)
+    {
+      _mm256_storeu_pd (out + i, _mm256_mul_pd (_mm256_loadu_pd (a + i), _mm256_loadu_pd (b + i)));
+    }
+#endif
+#if defined (__SSE2__)
+  for (; i + 2 <= n; i += 2)
+    {
+      _mm_storeu_pd (out + i, _mm_mul_pd (_mm_loadu_pd (a + i), _mm_loadu_pd (b + i)));
+    }
+#endif
+  for (; i < n; i++)
+    {
+      out[i] = a[i] * b[i];
+    }
+}
+
+template <uint32_t nBands>
+void
+AddBands (const double *a, const double *b, double *out, uint32_t n)
+{
+  if (nBands > 0)
+    {
+      n = nBands;
+    }
+  uint32_t i = 0;
+#if defined (__AVX__)
+  for (; i + 4 <= n; i += 4)
+    {
+      _mm256_storeu_pd (out + i, _mm256_add_pd (_mm256_loadu_pd (a + i), _mm256_loadu_pd (b + i)));
+    }
+#endif
+#if defined (__SSE2__)
+  for (; i + 2 <= n; i += 2)
+    {
+      _mm_storeu_pd (out + i, _mm_add_pd (_mm_loadu_pd (a + i), _mm_loadu_pd (b + i)));
+    }
+#endif
+  for (; i < n; i++)
+    {
+      out[i] = a[i] + b[i];
+    }
+}
+
+template <uint32_t nBands>
+void
+SubtractBands (const double *a, const double *b, double *out, uint32_t n)
+{
+  if (nBands > 0)
+    {
+      n = nBands;
+    }
+  uint32_t i = 0;
+#if defined (__AVX__)
+  for (; i + 4 <= n; i += 4)
+    {
+      _mm256_storeu_pd (out + i, _mm256_sub_pd (_mm256_loadu_pd (a + i), _mm256_loadu_pd (b + i)));
+    }
+#endif
+#if defined (__SSE2__)
+  for (; i + 2 <= n; i += 2)
+    {
+      _mm_storeu_pd (out + i, _mm_sub_pd (_mm_loadu_pd (a + i), _mm_loadu_pd (b + i)));
+    }
+#endif
+  for (; i < n; i++)
+    {
+      out[i] = a[i] - b[i];
+    }
+}
+
+template <uint32_t nBands>
+void
+WeightedSumBands (const double * const *rows, const double *weights, uint32_t nRows,
+                  double *out, uint32_t n)
+{
+  if (nBands > 0)
+    {
+      n = nBands;
+    }
+  uint32_t i = 0;
+#if defined (__AVX__)
+  for (; i + 4 <= n; i += 4)
+    {
+      __m256d sum = _mm256_setzero_pd ();
+      for (uint32_t k = 0; k < nRows; k++)
+        {
+          sum = _mm256_add_pd (sum, _mm256_mul_pd (_mm256_set1_pd (weights[k]), _mm256_loadu_pd (rows[k] + i)));
+        }
+      _mm256_storeu_pd (out + i, sum);
+    }
+#endif
+#if defined (__SSE2__)
+  for (; i + 2 <= n; i += 2)
+    {
+      __m128d sum = _mm_setzero_pd ();
+      for (uint32_t k = 0; k < nRows; k++)
+        {
+          sum = _mm_add_pd (sum, _mm_mul_pd (_mm_set1_pd (weights[k]), _mm_loadu_pd (rows[k] + i)));
+        }
+      _mm_storeu_pd (out + i, sum);
+    }
+#endif
+  for (; i < n; i++)
+    {
+      double sum = 0.;
+      for (uint32_t k = 0; k < nRows; k++)
+        {
+          sum += weights[k] * rows[k][i];
+        }
+      out[i] = sum;
+    }
+}
+
+template <uint32_t nBands>
+void
+ExpBands (const double *x, double *out, uint32_t n)
+{
+  if (nBands > 0)
+    {
+      n = nBands;
+    }
+  uint32_t i = 0;
+#if defined (__AVX2__)
+  for (; i + 4 <= n; i += 4)
+    {
+      __m256d v = _mm256_loadu_pd (x + i);
+      __m256d valid = _mm256_cmp_pd (v, _mm256_set1_pd (g_expMin), _CMP_GE_OQ);
+      v = _mm256_min_pd (v, _mm256_set1_pd (g_expMax));
+      __m256d t = _mm256_add_pd (_mm256_mul_pd (v, _mm256_set1_pd (g_expLog2e)), _mm256_set1_pd (g_expRound));
+      __m256d k = _mm256_sub_pd (t, _mm256_set1_pd (g_expRound));
+      __m256d r = _mm256_sub_pd (_mm256_sub_pd (v, _mm256_mul_pd (k, _mm256_set1_pd (g_expLn2Hi))),
+                                 _mm256_mul_pd (k, _mm256_set1_pd (g_expLn2Lo)));
+      __m256d p = _mm256_set1_pd (g_expCoefficients[0]);
+      for (uint32_t j = 1; j < g_expNCoefficients; j++)
+        {
+          p = _mm256_add_pd (_mm256_mul_pd (p, r), _mm256_set1_pd (g_expCoefficients[j]));
+        }
+      __m256i bits = _mm256_sub_epi64 (_mm256_castpd_si256 (t), _mm256_castpd_si256 (_mm256_set1_pd (g_expRound)));
+      bits = _mm256_slli_epi64 (_mm256_add_epi64 (bits, _mm256_set1_epi64x (1023)), 52);
+      _mm256_storeu_pd (out + i, _mm256_and_pd (_mm256_mul_pd (p, _mm256_castsi256_pd (bits)), valid));
+    }
+#endif
+#if defined (__SSE2__)
+  for (; i + 2 <= n; i += 2)
+    {
+      __m128d v = _mm_loadu_pd (x + i);
+      __m128d valid = _mm_cmpge_pd (v, _mm_set1_pd (g_expMin));
+      v = _mm_min_pd (v, _mm_set1_pd (g_expMax));
+      __m128d t = _mm_add_pd (_mm_mul_pd (v, _mm_set1_pd (g_expLog2e)), _mm_set1_pd (g_expRound));
+      __m128d k = _mm_sub_pd (t, _mm_set1_pd (g_expRound));
+      __m128d r = _mm_sub_pd (_mm_sub_pd (v, _mm_mul_pd (k, _mm_set1_pd (g_expLn2Hi))),
+                              _mm_mul_pd (k, _mm_set1_pd (g_expLn2Lo)));
+      __m128d p = _mm_set1_pd (g_expCoefficients[0]);
+      for (uint32_t j = 1; j < g_expNCoefficients; j++)
+        {
+          p = _mm_add_pd (_mm_mul_pd (p, r), _mm_set1_pd (g_expCoefficients[j]));
+        }
+      __m128i bits = _mm_sub_epi64 (_mm_castpd_si128 (t), _mm_castpd_si128 (_mm_set1_pd (g_expRound)));
+      bits = _mm_slli_epi64 (_mm_add_epi64 (bits, _mm_set1_epi64x (1023)), 52);
+      _mm_storeu_pd (out + i, _mm_and_pd (_mm_mul_pd (p, _mm_castsi128_pd (bits)), valid));
+    }
+#endif
+  for (; i < n; i++)
+    {
+      out[i] = ExpScalar (x[i]);
+    }
+}
+
+template <uint32_t nBands>
+void
+Log2OnePlusBands (const double *x, double *out, uint32_t n, P1906EMBandKernels::Precision precision)
+{
+  if (precision == P1906EMBandKernels::FAST)
+    {
+      Log2OnePlusTerms<nBands, g_logFirstFast> (x, out, n);
+    }
+  else
+    {
+      Log2OnePlusTerms<nBands, 0> (x, out, n);
+    }
+}
+
+template <uint32_t nBands>
+double
+SumLog2OnePlusRatioBands (const double *a, const double *b, uint32_t n, double limit,
+                          P1906EMBandKernels::Precision precision)
+{
+  if (precision == P1906EMBandKernels::FAST)
+    {
+      return SumLog2OnePlusRatioTerms<nBands, g_logFirstFast> (a, b, n, limit);
+    }
+  return SumLog2OnePlusRatioTerms<nBands, 0> (a, b, n, limit);
+}
+
+}
+
+/*
+ * Calls kernel<nBands> for the band counts instantiated at compile time,
+ * whose loops have constant trip counts, and kernel<0> for any other one.
+ */
+#define P1906_EM_BAND_DISPATCH(kernel, n, arguments) \
+  switch (n)                                         \
+    {                                                \
+    case 11:                                         \
+      return kernel<11> arguments;                   \
+    case 16:                                         \
+      return kernel<16> arguments;                   \
+    case 32:                                         \
+      return kernel<32> arguments;                   \
+    case 64:                                         \
+      return kernel<64> arguments;                   \
+    default:                                         \
+      return kernel<0> arguments;                    \
+    }
+
+void
+P1906EMBandKernels::Multiply (const double *a, const double *b, double *out, uint32_t n)
+{
+  P1906_EM_BAND_DISPATCH (MultiplyBands, n, (a, b, out, n));
+}
+
+void
+P1906EMBandKernels::Add (const double *a, const double *b, double *out, uint32_t n)
+{
+  P1906_EM_BAND_DISPATCH (AddBands, n, (a, b, out, n));
+}
+
+void
+P1906EMBandKernels::Subtract (const double *a, const double *b, double *out, uint32_t n)
+{
+  P1906_EM_BAND_DISPATCH (SubtractBands, n, (a, b, out, n));
+}
+
+void
+P1906EMBandKernels::WeightedSum (const double * const *rows, const double *weights, uint32_t nRows,
+                                 double *out, uint32_t n)
+{
+  P1906_EM_BAND_DISPATCH (WeightedSumBands, n, (rows, weights, nRows, out, n));
+}
+
+void
+P1906EMBandKernels::Exp (const double *x, double *out, uint32_t n)
+{
+  P1906_EM_BAND_DISPATCH (ExpBands, n, (x, out, n));
+}
+
+void
+P1906EMBandKernels::Log2OnePlus (const double *x, double *out, uint32_t n, Precision precision)
+{
+  P1906_EM_BAND_DISPATCH (Log2OnePlusBands, n, (x, out, n, precision));
+}
+
+double
+P1906EMBandKernels::SumLog2OnePlusRatio (const double *a, const double *b, uint32_t n,
+                                         double limit, Precision precision)
+{
+  P1906_EM_BAND_DISPATCH (SumLog2OnePlusRatioBands, n, (a, b, n, limit, precision));
+}
+
+#undef P1906_EM_BAND_DISPATCH
+
+bool
+P1906EMBandKernels::IsSpecialized (uint32_t n)
+{
+  return n == 11 || n == 16 || n == 32 || n == 64;
+}
+
+const char*
+P1906EMBandKernels::GetInstructionSet (void)
+{
+#if defined (__AVX__)
+  return "AVX";
+#elif defined (__SSE2__)
+  return "SSE2";
+#else
+  return "scalar";
+#endif
+}
+
+} // namespace ns3
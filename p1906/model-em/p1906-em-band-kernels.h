@@ -0,0 +1,122 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+
+#ifndef P1906_EM_BAND_KERNELS
+#define P1906_EM_BAND_KERNELS
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup P1906 framework
+ *
+ * \class P1906EMBandKernels
+ *
+ * \brief Vectorized operations over contiguous arrays of sub-band values,
+ * used by the EM components on the per-reception path.
+ *
+ * The kernels use AVX when the module is compiled with it enabled (e.g.,
+ * -mavx2), SSE2 on any other x86-64 build, and a scalar loop elsewhere.
+ * Exp and the logarithms need AVX2 for their 256-bit forms, since they work
+ * on the exponent bits; the EXACT logarithm is not vectorized on SSE2, where
+ * std::log2 is faster than a two-lane polynomial.
+ *
+ * Every kernel is instantiated for the common numbers of sub-bands (11, 16,
+ * 32 and 64), whose loops the compiler unrolls with constant trip counts,
+ * and dispatches any other number to a generic version sized at run time.
+ */
+
+class P1906EMBandKernels
+{
+public:
+  /**
+   * \brief the accuracy of the logarithm kernels
+   */
+  enum Precision
+  {
+    EXACT, //!< within 4 ulp of std::log2
+    FAST   //!< within 3e-6 of std::log2, with a shorter polynomial
+  };
+
+  /**
+   * \brief out[i] = a[i] * b[i], for i in [0, n). out may alias a or b.
+   */
+  static void Multiply (const double *a, const double *b, double *out, uint32_t n);
+  /**
+   * \brief out[i] = a[i] + b[i], for i in [0, n). out may alias a or b.
+   */
+  static void Add (const double *a, const double *b, double *out, uint32_t n);
+  /**
+   * \brief out[i] = a[i] - b[i], for i in [0, n). out may alias a or b.
+   */
+  static void Subtract (const double *a, const double *b, double *out, uint32_t n);
+  /**
+   * \brief out[i] = sum of weights[k] * rows[k][i] over the nRows rows, for
+   * i in [0, n). out may alias any of the rows.
+   */
+  static void WeightedSum (const double * const *rows, const double *weights, uint32_t nRows,
+                           double *out, uint32_t n);
+  /**
+   * \brief out[i] = e^x[i], for i in [0, n), within 2 ulp of std::exp. The
+   * results below DBL_MIN, i.e., for x[i] < ln (DBL_MIN), are flushed to 0,
+   * and x[i] is clamped to 709, close to ln (DBL_MAX). out may alias x.
+   */
+  static void Exp (const double *x, double *out, uint32_t n);
+  /**
+   * \brief out[i] = log2 (1 + x[i]), for i in [0, n) and finite x[i] >= 0.
+   * out may alias x.
+   */
+  static void Log2OnePlus (const double *x, double *out, uint32_t n, Precision precision);
+  /**
+   * \brief the sum of log2 (1 + a[i] / b[i]) over i in [0, n), e.g., the
+   * Shannon capacity per Hz of sub-bands with signal powers a and noise
+   * powers b.
+   *
+   * The terms are non-negative for a[i] >= 0 and b[i] > 0, so the sum stops
+   * as soon as it reaches limit: the result is then a partial sum, not
+   * smaller than limit.
+   */
+  static double SumLog2OnePlusRatio (const double *a, const double *b, uint32_t n,
+                                     double limit, Precision precision);
+
+  /**
+   * \return whether the kernels have a version instantiated for n sub-bands
+   */
+  static bool IsSpecialized (uint32_t n);
+
+  /**
+   * \return the name of the instruction set selected at compile time
+   */
+  static const char* GetInstructionSet (void);
+};
+
+}
+
+#endif /* P1906_EM_BAND_KERNELS */
@@ -0,0 +1,54 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+
+#ifndef P1906_EM_CHANNEL_TABLE_DATA
+#define P1906_EM_CHANNEL_TABLE_DATA
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/*
+ * Reference tables of the EM example, defined in
+ * p1906-em-channel-table-data.cc and exposed through
+ * P1906EMChannelTable::GetDefault. Not installed: only the channel table
+ * refers to them.
+ */
+
+const uint32_t g_p1906EMReferenceNDistances = 1000;
+const uint32_t g_p1906EMReferenceNBands = 11;
+
+extern const double g_p1906EMReferenceDistances[g_p1906EMReferenceNDistances];
+extern const double g_p1906EMReferenceBandFrequencies[g_p1906EMReferenceNBands];
+extern const double g_p1906EMReferencePathLoss[g_p1906EMReferenceNDistances][g_p1906EMReferenceNBands];
+extern const double g_p1906EMReferenceMolecularNoise[g_p1906EMReferenceNDistances][g_p1906EMReferenceNBands];
+
+}
+
+#endif /* P1906_EM_CHANNEL_TABLE_DATA */
@@ -0,0 +1,537 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+
+#include "ns3/log.h"
+
+#include "ns3/global-value.h"
+#include "ns3/string.h"
+
+#include "p1906-em-channel-table.h"
+#include "p1906-em-channel-table-data.h"
+#include "p1906-em-band-kernels.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("P1906EMChannelTable");
+
+static GlobalValue g_channelTableFile ("P1906EMChannelTableFile",
+                                       "The binary channel table (see P1906EMChannelTable::Write) used "
+                                       "instead of the reference one by the EM components, if not empty",
+                                       StringValue (""),
+                                       MakeStringChecker ());
+
+static GlobalValue g_channelInterpolation ("P1906EMChannelInterpolation",
+                                           "The mapping of the distances to the channel table used by the "
+                                           "EM components: LowerBin, NearestBin, Linear or Cubic",
+                                           StringValue ("LowerBin"),
+                                           MakeStringChecker ());
+
+namespace {
+
+const char g_fileMagic[8] = { 'P', '1', '9', '0', '6', 'E', 'M', 'T' };
+const uint32_t g_fileVersion = 1;
+const uint32_t g_fileByteOrder = 0x01020304;
+const uint64_t g_fileAlignment = 64;
+
+enum FileUnit
+{
+  UNIT_METER = 1,
+  UNIT_HERTZ = 2,
+  UNIT_DECIBEL = 3,
+  UNIT_KELVIN = 4
+};
+
+struct FileHeader
+{
+  char m_magic[8];
+  uint32_t m_version;
+  uint32_t m_headerSize;
+  uint32_t m_byteOrder;
+  uint32_t m_nDistances;
+  uint32_t m_nBands;
+  uint32_t m_distanceUnit;
+  uint32_t m_frequencyUnit;
+  uint32_t m_pathLossUnit;
+  uint32_t m_noiseUnit;
+  uint32_t m_reserved;
+  uint64_t m_distancesOffset;
+  uint64_t m_bandFrequenciesOffset;
+  uint64_t m_pathLossOffset;
+  uint64_t m_pathLossGainOffset;
+  uint64_t m_molecularNoiseOffset;
+  uint64_t m_fileSize;
+};
+
+uint64_t
+Align (uint64_t offset)
+{
+  return (offset + g_fileAlignment - 1) / g_fileAlignment * g_fileAlignment;
+}
+
+bool
+IsSectionValid (uint64_t offset, uint64_t nValues, uint64_t fileSize)
+{
+  return offset % sizeof (double) == 0 && offset >= sizeof (FileHeader) &&
+    offset <= fileSize && nValues <= (fileSize - offset) / sizeof (double);
+}
+
+}
+
+Ptr<const P1906EMChannelTable>
+P1906EMChannelTable::GetDefault (void)
+{
+  static Ptr<const P1906EMChannelTable> table = CreateDefault ();
+  return table;
+}
+
+Ptr<const P1906EMChannelTable>
+P1906EMChannelTable::CreateDefault (void)
+{
+  StringValue fileName;
+  g_channelTableFile.GetValue (fileName);
+  if (fileName.Get () != "")
+    {
+      Ptr<const P1906EMChannelTable> table = Load (fileName.Get ());
+      if (table == 0)
+        {
+          NS_FATAL_ERROR ("invalid EM channel table file " << fileName.Get ());
+        }
+      return table;
+    }
+  return Ptr<const P1906EMChannelTable> (new P1906EMChannelTable (g_p1906EMReferenceNDistances,
+                                                                  g_p1906EMReferenceNBands,
+                                                                  g_p1906EMReferenceDistances,
+                                                                  g_p1906EMReferenceBandFrequencies,
+                                                                  &g_p1906EMReferencePathLoss[0][0],
+                                                                  0,
+                                                                  &g_p1906EMReferenceMolecularNoise[0][0]),
+                                         false);
+}
+
+Ptr<const P1906EMChannelTable>
+P1906EMChannelTable::Load (std::string fileName)
+{
+  NS_LOG_FUNCTION (fileName);
+  int fd = open (fileName.c_str (), O_RDONLY);
+  if (fd < 0)
+    {
+      NS_LOG_WARN ("cannot open " << fileName);
+      return 0;
+    }
+  struct stat status;
+  if (fstat (fd, &status) != 0 || status.st_size < (off_t) sizeof (FileHeader))
+    {
+      NS_LOG_WARN ("cannot read the header of " << fileName);
+      close (fd);
+      return 0;
+    }
+  uint64_t size = status.st_size;
+  void *mapping = mmap (0, size, PROT_READ, MAP_SHARED, fd, 0);
+  close (fd);
+  if (mapping == MAP_FAILED)
+    {
+      NS_LOG_WARN ("cannot map " << fileName);
+      return 0;
+    }
+  // the bins are looked up at random: do not read ahead
+  madvise (mapping, size, MADV_RANDOM);
+
+  const char *base = static_cast<const char*> (mapping);
+  FileHeader header;
+  std::memcpy (&header, base, sizeof (header));
+  uint64_t nValues = (uint64_t) header.m_nDistances * header.m_nBands;
+  bool valid = std::memcmp (header.m_magic, g_fileMagic, sizeof (g_fileMagic)) == 0 &&
+    header.m_version == g_fileVersion &&
+    header.m_headerSize == sizeof (FileHeader) &&
+    header.m_byteOrder == g_fileByteOrder &&
+    header.m_nDistances > 0 && header.m_nBands > 0 &&
+    header.m_distanceUnit == UNIT_METER && header.m_frequencyUnit == UNIT_HERTZ &&
+    header.m_pathLossUnit == UNIT_DECIBEL && header.m_noiseUnit == UNIT_KELVIN &&
+    header.m_fileSize == size &&
+    IsSectionValid (header.m_distancesOffset, header.m_nDistances, size) &&
+    IsSectionValid (header.m_bandFrequenciesOffset, header.m_nBands, size) &&
+    IsSectionValid (header.m_pathLossOffset, nValues, size) &&
+    IsSectionValid (header.m_pathLossGainOffset, nValues, size) &&
+    IsSectionValid (header.m_molecularNoiseOffset, nValues, size);
+
+  const double *distances = reinterpret_cast<const double*> (base + header.m_distancesOffset);
+  for (uint32_t i = 1; valid && i < header.m_nDistances; i++)
+    {
+      valid = distances[i - 1] < distances[i];
+    }
+  if (!valid)
+    {
+      NS_LOG_WARN (fileName << " is not a valid version " << g_fileVersion << " channel table");
+      munmap (mapping, size);
+      return 0;
+    }
+
+  P1906EMChannelTable *table =
+    new P1906EMChannelTable (header.m_nDistances, header.m_nBands, distances,
+                             reinterpret_cast<const double*> (base + header.m_bandFrequenciesOffset),
+                             reinterpret_cast<const double*> (base + header.m_pathLossOffset),
+                             reinterpret_cast<const double*> (base + header.m_pathLossGainOffset),
+                             reinterpret_cast<const double*> (base + header.m_molecularNoiseOffset));
+  table->m_mapping = mapping;
+  table->m_mappingSize = size;
+  return Ptr<const P1906EMChannelTable> (table, false);
+}
+
+Ptr<const P1906EMChannelTable>
+P1906EMChannelTable::Create (uint32_t nDistances, uint32_t nBands,
+                             const double *distances,
+                             const double *bandFrequencies,
+                             const double *pathLoss,
+                             const double *molecularNoise)
+{
+  NS_LOG_FUNCTION ("[distances,bands]" << nDistances << nBands);
+  NS_ASSERT (nDistances > 0 && nBands > 0);
+  uint64_t nValues = (uint64_t) nDistances * nBands;
+  std::vector<double> storage;
+  storage.reserve (nDistances + nBands + 2 * nValues);
+  storage.insert (storage.end (), distances, distances + nDistances);
+  storage.insert (storage.end (), bandFrequencies, bandFrequencies + nBands);
+  storage.insert (storage.end (), pathLoss, pathLoss + nValues);
+  storage.insert (storage.end (), molecularNoise, molecularNoise + nValues);
+
+  const double *base = &storage[0];
+  P1906EMChannelTable *table =
+    new P1906EMChannelTable (nDistances, nBands, base, base + nDistances,
+                             base + nDistances + nBands, 0,
+                             base + nDistances + nBands + nValues);
+  // swapping keeps the buffer the table points to
+  table->m_storage.swap (storage);
+  return Ptr<const P1906EMChannelTable> (table, false);
+}
+
+P1906EMChannelTable::Interpolation
+P1906EMChannelTable::GetDefaultInterpolation (void)
+{
+  StringValue name;
+  g_channelInterpolation.GetValue (name);
+  Interpolation modes[] = { LOWER_BIN, NEAREST_BIN, LINEAR, CUBIC };
+  for (uint32_t i = 0; i < sizeof (modes) / sizeof (modes[0]); i++)
+    {
+      if (name.Get () == GetInterpolationName (modes[i]))
+        {
+          return modes[i];
+        }
+    }
+  NS_FATAL_ERROR ("invalid EM channel interpolation " << name.Get ());
+  return LOWER_BIN;
+}
+
+std::string
+P1906EMChannelTable::GetInterpolationName (Interpolation interpolation)
+{
+  switch (interpolation)
+    {
+    case LOWER_BIN:
+      return "LowerBin";
+    case NEAREST_BIN:
+      return "NearestBin";
+    case LINEAR:
+      return "Linear";
+    case CUBIC:
+      return "Cubic";
+    }
+  return "unknown";
+}
+
+bool
+P1906EMChannelTable::Write (std::string fileName) const
+{
+  NS_LOG_FUNCTION (this << fileName);
+  uint64_t nValues = (uint64_t) m_nDistances * m_nBands;
+
+  FileHeader header;
+  std::memset (&header, 0, sizeof (header));
+  std::memcpy (header.m_magic, g_fileMagic, sizeof (g_fileMagic));
+  header.m_version = g_fileVersion;
+  header.m_headerSize = sizeof (FileHeader);
+  header.m_byteOrder = g_fileByteOrder;
+  header.m_nDistances = m_nDistances;
+  header.m_nBands = m_nBands;
+  header.m_distanceUnit = UNIT_METER;
+  header.m_frequencyUnit = UNIT_HERTZ;
+  header.m_pathLossUnit = UNIT_DECIBEL;
+  header.m_noiseUnit = UNIT_KELVIN;
+  header.m_distancesOffset = Align (sizeof (FileHeader));
+  header.m_bandFrequenciesOffset = Align (header.m_distancesOffset + m_nDistances * sizeof (double));
+  header.m_pathLossOffset = Align (header.m_bandFrequenciesOffset + m_nBands * sizeof (double));
+  header.m_pathLossGainOffset = Align (header.m_pathLossOffset + nValues * sizeof (double));
+  header.m_molecularNoiseOffset = Align (header.m_pathLossGainOffset + nValues * sizeof (double));
+  header.m_fileSize = header.m_molecularNoiseOffset + nValues * sizeof (double);
+
+  std::ofstream file (fileName.c_str (), std::ios::binary | std::ios::trunc);
+  file.write (reinterpret_cast<const char*> (&header), sizeof (header));
+
+  struct Section
+  {
+    uint64_t m_offset;
+    const double *m_values;
+    uint64_t m_nValues;
+  };
+  Section sections[] = {
+    { header.m_distancesOffset, m_distances, m_nDistances },
+    { header.m_bandFrequenciesOffset, m_bandFrequencies, m_nBands },
+    { header.m_pathLossOffset, m_pathLoss, nValues },
+    { header.m_pathLossGainOffset, m_pathLossGain, nValues },
+    { header.m_molecularNoiseOffset, m_molecularNoise, nValues }
+  };
+  const char padding[g_fileAlignment] = { 0 };
+  uint64_t offset = sizeof (header);
+  for (uint32_t i = 0; i < sizeof (sections) / sizeof (sections[0]); i++)
+    {
+      file.write (padding, sections[i].m_offset - offset);
+      file.write (reinterpret_cast<const char*> (sections[i].m_values), sections[i].m_nValues * sizeof (double));
+      offset = sections[i].m_offset + sections[i].m_nValues * sizeof (double);
+    }
+  file.close ();
+  if (!file)
+    {
+      NS_LOG_WARN ("cannot write " << fileName);
+      return false;
+    }
+  return true;
+}
+
+P1906EMChannelTable::P1906EMChannelTable (uint32_t nDistances, uint32_t nBands,
+                                          const double *distances,
+                                          const double *bandFrequencies,
+                                          const double *pathLoss,
+                                          const double *pathLossGain,
+                                          const double *molecularNoise)
+  : m_nDistances (nDistances),
+    m_nBands (nBands),
+    m_distances (distances),
+    m_bandFrequencies (bandFrequencies),
+    m_pathLoss (pathLoss),
+    m_pathLossGain (pathLossGain),
+    m_molecularNoise (molecularNoise),
+    m_mapping (0),
+    m_mappingSize (0)
+{
+  NS_LOG_FUNCTION (this << "[distances,bands]" << nDistances << nBands);
+  m_distanceLookup.SetGrid (m_distances, m_nDistances);
+  NS_LOG_INFO ("distance bins found through " << m_distanceLookup.GetStrategyName ());
+
+  if (m_pathLossGain == 0)
+    {
+      m_computedPathLossGain.resize (m_nDistances * m_nBands);
+      for (uint32_t i = 0; i < m_computedPathLossGain.size (); i++)
+        {
+          m_computedPathLossGain[i] = std::pow (10., -m_pathLoss[i] / 10.);
+        }
+      m_pathLossGain = &m_computedPathLossGain[0];
+    }
+}
+
+P1906EMChannelTable::~P1906EMChannelTable ()
+{
+  NS_LOG_FUNCTION (this);
+  if (m_mapping != 0)
+    {
+      munmap (m_mapping, m_mappingSize);
+    }
+}
+
+uint32_t
+P1906EMChannelTable::GetNDistances (void) const
+{
+  return m_nDistances;
+}
+
+uint32_t
+P1906EMChannelTable::GetNBands (void) const
+{
+  return m_nBands;
+}
+
+double
+P1906EMChannelTable::GetDistance (uint32_t index) const
+{
+  NS_ASSERT (index < m_nDistances);
+  return m_distances[index];
+}
+
+const double*
+P1906EMChannelTable::GetDistances (void) const
+{
+  return m_distances;
+}
+
+const double*
+P1906EMChannelTable::GetBandFrequencies (void) const
+{
+  return m_bandFrequencies;
+}
+
+uint32_t
+P1906EMChannelTable::FindDistanceIndex (double distance) const
+{
+  return m_distanceLookup.FindIndex (distance);
+}
+
+const P1906GridLookup&
+P1906EMChannelTable::GetDistanceLookup (void) const
+{
+  return m_distanceLookup;
+}
+
+const double*
+P1906EMChannelTable::GetPathLoss (uint32_t index) const
+{
+  NS_ASSERT (index < m_nDistances);
+  return m_pathLoss + index * m_nBands;
+}
+
+const double*
+P1906EMChannelTable::GetPathLossGain (uint32_t index) const
+{
+  NS_ASSERT (index < m_nDistances);
+  return m_pathLossGain + index * m_nBands;
+}
+
+const double*
+P1906EMChannelTable::GetMolecularNoise (uint32_t index) const
+{
+  NS_ASSERT (index < m_nDistances);
+  return m_molecularNoise + index * m_nBands;
+}
+
+uint32_t
+P1906EMChannelTable::FindInterpolationBins (double distance, Interpolation interpolation,
+                                            uint32_t *bins, double *weights) const
+{
+  uint32_t index = FindDistanceIndex (distance);
+  bins[0] = index;
+  weights[0] = 1.;
+  if (interpolation == LOWER_BIN || index + 1 >= m_nDistances || distance <= m_distances[index])
+    {
+      // an exact grid distance, or one clamped to the first or to the last bin
+      return 1;
+    }
+
+  double lower = m_distances[index];
+  double upper = m_distances[index + 1];
+  if (interpolation == NEAREST_BIN)
+    {
+      if (distance - lower > upper - distance)
+        {
+          bins[0] = index + 1;
+        }
+      return 1;
+    }
+
+  if (interpolation == LINEAR || m_nDistances < 4)
+    {
+      double t = (distance - lower) / (upper - lower);
+      bins[1] = index + 1;
+      weights[0] = 1. - t;
+      weights[1] = t;
+      return 2;
+    }
+
+  // the four bins around the distance, shifted inside the grid at its ends
+  uint32_t first = index > 0 ? index - 1 : 0;
+  first = std::min (first, m_nDistances - 4);
+  for (uint32_t k = 0; k < 4; k++)
+    {
+      bins[k] = first + k;
+      weights[k] = 1.;
+      for (uint32_t j = 0; j < 4; j++)
+        {
+          if (j != k)
+            {
+              weights[k] *= (distance - m_distances[first + j]) / (m_distances[first + k] - m_distances[first + j]);
+            }
+        }
+    }
+  return 4;
+}
+
+void
+P1906EMChannelTable::InterpolatePathLossGain (double distance, Interpolation interpolation, double *gain) const
+{
+  uint32_t bins[4];
+  double weights[4];
+  uint32_t nBins = FindInterpolationBins (distance, interpolation, bins, weights);
+  if (nBins == 1)
+    {
+      std::memcpy (gain, GetPathLossGain (bins[0]), m_nBands * sizeof (double));
+      return;
+    }
+
+  // 10^(-pathLoss/10) = e^(-pathLoss * ln (10) / 10)
+  const double *rows[4];
+  for (uint32_t k = 0; k < nBins; k++)
+    {
+      rows[k] = GetPathLoss (bins[k]);
+      weights[k] *= -std::log (10.) / 10.;
+    }
+  P1906EMBandKernels::WeightedSum (rows, weights, nBins, gain, m_nBands);
+  P1906EMBandKernels::Exp (gain, gain, m_nBands);
+}
+
+void
+P1906EMChannelTable::InterpolateMolecularNoise (double distance, Interpolation interpolation, double *noise) const
+{
+  InterpolateRows (m_molecularNoise, distance, interpolation, noise);
+}
+
+void
+P1906EMChannelTable::InterpolateRows (const double *matrix, double distance, Interpolation interpolation,
+                                      double *values) const
+{
+  uint32_t bins[4];
+  double weights[4];
+  uint32_t nBins = FindInterpolationBins (distance, interpolation, bins, weights);
+  const double *rows[4];
+  for (uint32_t k = 0; k < nBins; k++)
+    {
+      rows[k] = matrix + bins[k] * m_nBands;
+    }
+  if (nBins == 1)
+    {
+      std::memcpy (values, rows[0], m_nBands * sizeof (double));
+      return;
+    }
+  P1906EMBandKernels::WeightedSum (rows, weights, nBins, values, m_nBands);
+}
+
+} // namespace ns3
@@ -0,0 +1,260 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+
+#ifndef P1906_EM_CHANNEL_TABLE
+#define P1906_EM_CHANNEL_TABLE
+
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/p1906-grid-lookup.h"
+#include <vector>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * \ingroup P1906 framework
+ *
+ * \class P1906EMChannelTable
+ *
+ * \brief Read-only container of the EM reference tables (Akram's path
+ * loss and molecular absorption noise), shared by the Motion and the
+ * Specificity components of the EM example.
+ *
+ * Both matrices are indexed by a distance bin (see GetDistance) and by a
+ * sub-band, and are stored row by row, so that a single bin exposes
+ * GetNBands () contiguous values. The reference table is built once per
+ * process and never modified afterwards.
+ *
+ * A table can also be loaded from a binary file (see Write for the
+ * format), which is mapped read-only in memory: its pages are loaded on
+ * demand and shared by every process using the same file. Setting the
+ * "P1906EMChannelTableFile" global value replaces the reference table
+ * with the table of that file.
+ *
+ * Between two grid distances, the path loss and the noise can be taken
+ * from the lower bin (the reference behaviour), from the nearest one, or
+ * interpolated across all the sub-bands at once (see Interpolation). The
+ * "P1906EMChannelInterpolation" global value selects the mode the EM
+ * components start with.
+ */
+
+class P1906EMChannelTable : public SimpleRefCount<P1906EMChannelTable>
+{
+public:
+  /**
+   * \brief how a distance between two grid points is mapped to the table
+   */
+  enum Interpolation
+  {
+    LOWER_BIN,   //!< the bin returned by FindDistanceIndex
+    NEAREST_BIN, //!< the bin of the nearest grid distance
+    LINEAR,      //!< linear interpolation between the two enclosing bins
+    CUBIC        //!< cubic (Lagrange) interpolation over the four nearest bins
+  };
+
+  /**
+   * \return the reference table, built on first use
+   */
+  static Ptr<const P1906EMChannelTable> GetDefault (void);
+
+  /**
+   * \param fileName a table written by Write
+   * \return the table mapped from the file, or 0 if it cannot be mapped or
+   * is not a valid table
+   */
+  static Ptr<const P1906EMChannelTable> Load (std::string fileName);
+
+  /**
+   * \brief builds a table holding a copy of the given arrays, e.g., a
+   * resampled version of another table. The matrices are stored row by row.
+   *
+   * \param nDistances the size of the increasing distance grid
+   * \param nBands the number of sub-bands
+   * \param distances the distance grid [m]
+   * \param bandFrequencies the central frequencies [Hz] of the sub-bands
+   * \param pathLoss the path loss [dB]
+   * \param molecularNoise the molecular absorption noise temperature [K]
+   */
+  static Ptr<const P1906EMChannelTable> Create (uint32_t nDistances, uint32_t nBands,
+                                                const double *distances,
+                                                const double *bandFrequencies,
+                                                const double *pathLoss,
+                                                const double *molecularNoise);
+
+  /**
+   * \return the mode selected by the "P1906EMChannelInterpolation" global
+   * value ("LowerBin", "NearestBin", "Linear" or "Cubic")
+   */
+  static Interpolation GetDefaultInterpolation (void);
+  static std::string GetInterpolationName (Interpolation interpolation);
+
+  /**
+   * \brief writes the table in the binary format read by Load.
+   *
+   * The file starts with a header of fixed size, in the byte order of the
+   * host: the magic "P1906EMT", the format version, the header size, a
+   * byte order mark, the numbers of distance bins and of sub-bands, the
+   * units of the distances (m), of the band frequencies (Hz), of the path
+   * loss (dB) and of the noise (K), then the offsets of the sections and
+   * the file size. The sections are the distance grid, the central
+   * frequency of each sub-band, and the path loss, its linear gain and the
+   * molecular noise matrices, stored row by row; each one starts on a
+   * 64-byte boundary.
+   *
+   * \param fileName the file to create or overwrite
+   * \return whether the file has been written
+   */
+  bool Write (std::string fileName) const;
+
+  ~P1906EMChannelTable ();
+
+  uint32_t GetNDistances (void) const;
+  uint32_t GetNBands (void) const;
+
+  /**
+   * \param index the distance bin
+   * \return the distance [m] of the bin
+   */
+  double GetDistance (uint32_t index) const;
+  const double* GetDistances (void) const;
+
+  /**
+   * \return the central frequencies [Hz] of the GetNBands () sub-bands
+   */
+  const double* GetBandFrequencies (void) const;
+
+  /**
+   * \param distance the distance [m] between transmitter and receiver
+   * \return the bin of the largest grid distance not greater than the
+   * given one, clamped to the first and to the last bins
+   */
+  uint32_t FindDistanceIndex (double distance) const;
+
+  /**
+   * \return the lookup used by FindDistanceIndex, which reports the
+   * strategy chosen for the distance grid
+   */
+  const P1906GridLookup& GetDistanceLookup (void) const;
+
+  /**
+   * \param index the distance bin
+   * \return the path loss [dB] of the GetNBands () sub-bands
+   */
+  const double* GetPathLoss (uint32_t index) const;
+
+  /**
+   * \param index the distance bin
+   * \return the path loss of the GetNBands () sub-bands as linear gain
+   * factors, i.e., 10^(-pathLoss/10), computed once when the table is built
+   */
+  const double* GetPathLossGain (uint32_t index) const;
+
+  /**
+   * \param index the distance bin
+   * \return the molecular absorption noise temperature [K] of the
+   * GetNBands () sub-bands
+   */
+  const double* GetMolecularNoise (uint32_t index) const;
+
+  /**
+   * \brief the path loss of the GetNBands () sub-bands at the given distance,
+   * as linear gain factors. LINEAR and CUBIC interpolate the path loss in dB,
+   * which varies smoothly with the distance whereas the gain falls by orders
+   * of magnitude from a bin to the next one, and convert the result with
+   * P1906EMBandKernels::Exp. Beyond the grid, the first and the last bins
+   * are used.
+   *
+   * \param distance the distance [m] between transmitter and receiver
+   * \param interpolation the mapping of the distance to the table
+   * \param gain filled with GetNBands () values
+   */
+  void InterpolatePathLossGain (double distance, Interpolation interpolation, double *gain) const;
+
+  /**
+   * \brief the molecular absorption noise temperature [K] of the GetNBands ()
+   * sub-bands at the given distance, interpolated like the path loss
+   *
+   * \param distance the distance [m] between transmitter and receiver
+   * \param interpolation the mapping of the distance to the table
+   * \param noise filled with GetNBands () values
+   */
+  void InterpolateMolecularNoise (double distance, Interpolation interpolation, double *noise) const;
+
+private:
+  /**
+   * \brief finds the bins and the weights interpolating the given distance
+   *
+   * \param bins filled with up to four bins
+   * \param weights filled with the weight of each bin
+   * \return the number of bins used
+   */
+  uint32_t FindInterpolationBins (double distance, Interpolation interpolation,
+                                  uint32_t *bins, double *weights) const;
+  /**
+   * \brief interpolates the rows of a matrix of the table, stored row by row
+   */
+  void InterpolateRows (const double *matrix, double distance, Interpolation interpolation,
+                        double *values) const;
+
+  static Ptr<const P1906EMChannelTable> CreateDefault (void);
+
+  /**
+   * \param pathLossGain the linear gains of pathLoss, or 0 to compute them
+   */
+  P1906EMChannelTable (uint32_t nDistances, uint32_t nBands,
+                       const double *distances,
+                       const double *bandFrequencies,
+                       const double *pathLoss,
+                       const double *pathLossGain,
+                       const double *molecularNoise);
+
+  P1906EMChannelTable (const P1906EMChannelTable &);
+  P1906EMChannelTable &operator= (const P1906EMChannelTable &);
+
+  uint32_t m_nDistances;
+  uint32_t m_nBands;
+  const double *m_distances;
+  const double *m_bandFrequencies;
+  const double *m_pathLoss;
+  const double *m_pathLossGain;
+  const double *m_molecularNoise;
+  std::vector<double> m_computedPathLossGain;
+  // the arrays the pointers refer to, for the tables built by Create
+  std::vector<double> m_storage;
+  P1906GridLookup m_distanceLookup;
+
+  // the file mapping the arrays point to, if any
+  void *m_mapping;
+  uint64_t m_mappingSize;
+};
+
+}
+
+#endif /* P1906_EM_CHANNEL_TABLE */
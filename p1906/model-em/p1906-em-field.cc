@@ -54,4 +54,10 @@ P1906EMField::~P1906EMField ()
   NS_LOG_FUNCTION (this);
 }
 
+bool
+P1906EMField::IsEmpty (void) const
+{
+  return GetInstanceTypeId () == P1906EMField::GetTypeId ();
+}
+
 } // namespace ns3
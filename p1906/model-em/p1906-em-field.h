@@ -53,6 +53,12 @@ public:
   P1906EMField ();
   virtual ~P1906EMField ();
 
+  /**
+   * \returns true for a P1906EMField, false for its subclasses that do not
+   * override it
+   */
+  virtual bool IsEmpty (void) const;
+
 };
 
 }
@@ -31,11 +31,41 @@
 #include "ns3/packet.h"
 #include "p1906-em-message-carrier.h"
 #include "ns3/p1906-message-carrier.h"
+#include <algorithm>
+#include <map>
+#include <vector>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("P1906EMMessageCarrier");
 
+/*
+ * Band arrays of the received carriers, recycled by number of bands. The
+ * free lists are never destroyed, as carriers may still be released after
+ * the static objects of the program.
+ */
+static std::map<uint32_t, std::vector<double*> > *g_freeBandValues =
+  new std::map<uint32_t, std::vector<double*> > ();
+
+static double*
+AcquireBandValues (uint32_t n)
+{
+  std::vector<double*> &freeList = (*g_freeBandValues)[n];
+  if (freeList.empty ())
+    {
+      return new double[n];
+    }
+  double *values = freeList.back ();
+  freeList.pop_back ();
+  return values;
+}
+
+static void
+RecycleBandValues (double *values, uint32_t n)
+{
+  (*g_freeBandValues)[n].push_back (values);
+}
+
 TypeId P1906EMMessageCarrier::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::P1906EMMessageCarrier")
@@ -44,128 +74,286 @@ TypeId P1906EMMessageCarrier::GetTypeId (void)
 }
 
 P1906EMMessageCarrier::P1906EMMessageCarrier ()
+  : m_received (false),
+    m_bandValues (0),
+    m_nBands (0)
 {
   NS_LOG_FUNCTION (this);
   SetMessage (0);
+  m_parameters = GetDefaultParameters ();
 }
 
 P1906EMMessageCarrier::~P1906EMMessageCarrier ()
 {
   NS_LOG_FUNCTION (this);
   SetMessage (0);
+  ReleaseBandValues ();
+  m_parameters = 0;
+  m_rxSpectrumValue = 0;
+}
+
+Ptr<P1906EMMessageCarrier::Parameters>
+P1906EMMessageCarrier::GetDefaultParameters (void)
+{
+  // shared by all the carriers until their first Set call
+  static Ptr<Parameters> parameters = Create<Parameters> ();
+  return parameters;
+}
+
+void
+P1906EMMessageCarrier::DetachParameters (void)
+{
+  if (m_parameters->GetReferenceCount () > 1)
+    {
+      m_parameters = Create<Parameters> (*m_parameters);
+    }
+}
+
+void
+P1906EMMessageCarrier::OwnSpectrumValue (void)
+{
+  // a PSD shared with the registry or with the received carriers is copied
+  // before it can be modified
+  if (m_parameters->m_spectrumValue != 0 &&
+      (m_parameters->m_ownedSpectrumValue == 0 || m_parameters->GetReferenceCount () > 1))
+    {
+      DetachParameters ();
+      m_parameters->m_ownedSpectrumValue = m_parameters->m_spectrumValue->Copy ();
+      m_parameters->m_spectrumValue = m_parameters->m_ownedSpectrumValue;
+    }
+}
+
+const double*
+P1906EMMessageCarrier::PeekBandValues (void) const
+{
+  if (m_received && m_rxSpectrumValue == 0)
+    {
+      return m_bandValues;
+    }
+  Ptr<const SpectrumValue> sv = m_received ? Ptr<const SpectrumValue> (m_rxSpectrumValue) : m_parameters->m_spectrumValue;
+  if (sv == 0)
+    {
+      return 0;
+    }
+  return &(*sv->ConstValuesBegin ());
+}
+
+void
+P1906EMMessageCarrier::ReleaseBandValues (void)
+{
+  if (m_bandValues != 0)
+    {
+      RecycleBandValues (m_bandValues, m_nBands);
+      m_bandValues = 0;
+    }
+}
+
+Ptr<P1906EMMessageCarrier>
+P1906EMMessageCarrier::CreateReceivedMessageCarrier (void)
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<P1906EMMessageCarrier> carrier = CreateObject<P1906EMMessageCarrier> ();
+  carrier->SetMessage (GetMessage ());
+  carrier->m_parameters = m_parameters;
+  carrier->m_received = true;
+  carrier->m_nBands = GetNBands ();
+  carrier->m_bandValues = AcquireBandValues (carrier->m_nBands);
+
+  const double *values = PeekBandValues ();
+  std::copy (values, values + carrier->m_nBands, carrier->m_bandValues);
+  return carrier;
+}
+
+bool
+P1906EMMessageCarrier::IsReceivedMessageCarrier (void)
+{
+  NS_LOG_FUNCTION (this);
+  return m_received;
+}
+
+double*
+P1906EMMessageCarrier::GetBandValues (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_received)
+    {
+      OwnSpectrumValue ();
+    }
+  return const_cast<double *> (PeekBandValues ());
 }
 
+uint32_t
+P1906EMMessageCarrier::GetNBands (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_received)
+    {
+      return m_nBands;
+    }
+  Ptr<const SpectrumValue> sv = m_parameters->m_spectrumValue;
+  return (sv == 0) ? 0 : sv->GetSpectrumModel ()->GetNumBands ();
+}
 
 void
 P1906EMMessageCarrier::SetSpectrumValue (Ptr<SpectrumValue> s)
 {
   NS_LOG_FUNCTION (this << s);
-  m_spectrumValue = s;
+  if (m_received)
+    {
+      // replaces the received PSD only
+      ReleaseBandValues ();
+      m_rxSpectrumValue = s;
+      m_nBands = s->GetSpectrumModel ()->GetNumBands ();
+      return;
+    }
+  DetachParameters ();
+  m_parameters->m_spectrumValue = s;
+  m_parameters->m_ownedSpectrumValue = s;
+}
+
+void
+P1906EMMessageCarrier::SetSharedSpectrumValue (Ptr<const SpectrumValue> s)
+{
+  NS_LOG_FUNCTION (this << s);
+  NS_ASSERT (!m_received);
+  DetachParameters ();
+  m_parameters->m_spectrumValue = s;
+  m_parameters->m_ownedSpectrumValue = 0;
 }
 
 Ptr<SpectrumValue>
 P1906EMMessageCarrier::GetSpectrumValue (void)
 {
   NS_LOG_FUNCTION (this);
-  return m_spectrumValue;
+  if (!m_received)
+    {
+      OwnSpectrumValue ();
+      return m_parameters->m_ownedSpectrumValue;
+    }
+  if (m_rxSpectrumValue == 0)
+    {
+      /*
+       * The received PSD is requested as a SpectrumValue: from now on the
+       * band values of the carrier are stored within it, so that updates
+       * made through either interface remain visible to the other one.
+       */
+      m_rxSpectrumValue = Create<SpectrumValue> (m_parameters->m_spectrumValue->GetSpectrumModel ());
+      std::copy (m_bandValues, m_bandValues + m_nBands, m_rxSpectrumValue->ValuesBegin ());
+      ReleaseBandValues ();
+    }
+  return m_rxSpectrumValue;
+}
+
+Ptr<const SpectrumValue>
+P1906EMMessageCarrier::GetTxSpectrumValue (void)
+{
+  NS_LOG_FUNCTION (this);
+  return m_parameters->m_spectrumValue;
 }
 
 void
 P1906EMMessageCarrier::SetDuration (Time t)
 {
   NS_LOG_FUNCTION (this << t);
-  m_duration = t;
+  DetachParameters ();
+  m_parameters->m_duration = t;
 }
 
 Time
 P1906EMMessageCarrier::GetDuration (void)
 {
   NS_LOG_FUNCTION (this);
-  return m_duration;
+  return m_parameters->m_duration;
 }
 
 void
 P1906EMMessageCarrier::SetPulseDuration (Time t)
 {
   NS_LOG_FUNCTION (this << t);
-  m_pulseDuration = t;
+  DetachParameters ();
+  m_parameters->m_pulseDuration = t;
 }
 
 Time
 P1906EMMessageCarrier::GetPulseDuration (void)
 {
   NS_LOG_FUNCTION (this);
-  return m_pulseDuration;
+  return m_parameters->m_pulseDuration;
 }
 
 void
 P1906EMMessageCarrier::SetPulseInterval (Time t)
 {
   NS_LOG_FUNCTION (this << t);
-  m_pulseInterval = t;
+  DetachParameters ();
+  m_parameters->m_pulseInterval = t;
 }
 
 Time
 P1906EMMessageCarrier::GetPulseInterval (void)
 {
   NS_LOG_FUNCTION (this);
-  return m_pulseInterval;
+  return m_parameters->m_pulseInterval;
 }
 
 void
 P1906EMMessageCarrier::SetStartTime (Time t)
 {
   NS_LOG_FUNCTION (this << t);
-  m_startTime = t;
+  DetachParameters ();
+  m_parameters->m_startTime = t;
 }
 
 Time
 P1906EMMessageCarrier::GetStartTime (void)
 {
   NS_LOG_FUNCTION (this);
-  return m_startTime;
+  return m_parameters->m_startTime;
 }
 
 void
 P1906EMMessageCarrier::SetCentralFrequency (double f)
 {
   NS_LOG_FUNCTION (this << f);
-  m_centralFrequency = f;
+  DetachParameters ();
+  m_parameters->m_centralFrequency = f;
 }
 
 double
 P1906EMMessageCarrier::GetCentralFrequency (void)
 {
   NS_LOG_FUNCTION (this);
-  return m_centralFrequency;
+  return m_parameters->m_centralFrequency;
 }
 
 void
 P1906EMMessageCarrier::SetBandwidth (double b)
 {
   NS_LOG_FUNCTION (this << b);
-  m_bandwidth = b;
+  DetachParameters ();
+  m_parameters->m_bandwidth = b;
 }
 
 double
 P1906EMMessageCarrier::GetBandwidth (void)
 {
   NS_LOG_FUNCTION (this);
-  return m_bandwidth;
+  return m_parameters->m_bandwidth;
 }
 
 void
 P1906EMMessageCarrier::SetSubChannel (double c)
 {
   NS_LOG_FUNCTION (this << c);
-  m_subChannel = c;
+  DetachParameters ();
+  m_parameters->m_subChannel = c;
 }
 
 double
 P1906EMMessageCarrier::GetSubChannel (void)
 {
   NS_LOG_FUNCTION (this);
-  return m_subChannel;
+  return m_parameters->m_subChannel;
 }
 
 } // namespace ns3
@@ -34,6 +34,7 @@
 #include "ns3/nstime.h"
 #include "ns3/ptr.h"
 #include "ns3/p1906-message-carrier.h"
+#include "ns3/simple-ref-count.h"
 #include <ns3/spectrum-value.h>
 
 
@@ -48,6 +49,12 @@ class SpectrumValue;
  *
  * \brief Base class implementing the Message Carrier component of
  * the P1906 framework
+ *
+ * The transmission parameters and the transmitted PSD are shared, with
+ * copy-on-write semantics, between a transmitted carrier and the received
+ * carriers created from it (see CreateReceivedMessageCarrier), which only
+ * own their band values. The transmitted PSD itself is usually interned by
+ * P1906EMSpectrumRegistry and must not be modified in place.
  */
 
 class P1906EMMessageCarrier : public P1906MessageCarrier
@@ -59,16 +66,49 @@ public:
   virtual ~P1906EMMessageCarrier ();
 
   void SetSpectrumValue (Ptr<SpectrumValue>);
+  /**
+   * \brief sets a transmitted PSD shared with other transmissions, e.g.,
+   * interned by P1906EMSpectrumRegistry; the carrier copies it before
+   * handing it out for modification
+   */
+  void SetSharedSpectrumValue (Ptr<const SpectrumValue>);
+  /**
+   * \return the PSD of the carrier: the received one for a received
+   * carrier, the transmitted one otherwise, copied first if it is shared
+   * (see SetSharedSpectrumValue)
+   */
   Ptr<SpectrumValue> GetSpectrumValue (void);
 
+  /**
+   * \return a carrier seen by a single receiver: it shares the packet, the
+   * transmission parameters and the transmitted PSD of this carrier, and
+   * owns a pooled copy of its GetNBands () band values, to be attenuated
+   * by the Motion component without altering the transmitted PSD
+   */
+  Ptr<P1906EMMessageCarrier> CreateReceivedMessageCarrier (void);
+  bool IsReceivedMessageCarrier (void);
+
+  /**
+   * \return the PSD [W/Hz] of the carrier as GetNBands () contiguous
+   * values: the received ones for a received carrier, the transmitted ones
+   * otherwise, copied first if they are shared (see GetSpectrumValue)
+   */
+  double* GetBandValues (void);
+  uint32_t GetNBands (void);
+
+  /**
+   * \return the transmitted PSD, also for a received carrier
+   */
+  Ptr<const SpectrumValue> GetTxSpectrumValue (void);
+
   void SetDuration (Time t);
-  Time GetDuration (void);
+  virtual Time GetDuration (void);
   void SetPulseDuration (Time t);
   Time GetPulseDuration (void);
   void SetPulseInterval (Time t);
   Time GetPulseInterval (void);
   void SetStartTime (Time t);
-  Time GetStartTime (void);
+  virtual Time GetStartTime (void);
 
   void SetCentralFrequency (double f);
   double GetCentralFrequency (void);
@@ -78,14 +118,43 @@ public:
   double GetSubChannel (void);
 
 private:
-  Ptr<SpectrumValue> m_spectrumValue;
-  Time m_duration;
-  Time m_pulseDuration;
-  Time m_pulseInterval;
-  Time m_startTime;
-  double m_centralFrequency;
-  double m_bandwidth;
-  double m_subChannel;
+  /**
+   * Parameters set by the Perturbation component, shared by the carriers
+   * of the same transmission
+   */
+  struct Parameters : public SimpleRefCount<Parameters>
+  {
+    Parameters ()
+      : m_centralFrequency (0.),
+        m_bandwidth (0.),
+        m_subChannel (0.)
+    {
+    }
+
+    Ptr<const SpectrumValue> m_spectrumValue;
+    Ptr<SpectrumValue> m_ownedSpectrumValue; // m_spectrumValue, unless it is shared
+    Time m_duration;
+    Time m_pulseDuration;
+    Time m_pulseInterval;
+    Time m_startTime;
+    double m_centralFrequency;
+    double m_bandwidth;
+    double m_subChannel;
+  };
+
+  static Ptr<Parameters> GetDefaultParameters (void);
+  void DetachParameters (void);
+  void OwnSpectrumValue (void);
+  const double* PeekBandValues (void) const;
+  void ReleaseBandValues (void);
+
+  Ptr<Parameters> m_parameters;
+
+  // received carriers only
+  bool m_received;
+  double *m_bandValues;
+  uint32_t m_nBands;
+  Ptr<SpectrumValue> m_rxSpectrumValue;
 };
 
 }
@@ -34,6 +34,7 @@
 #include "ns3/nstime.h"
 #include "ns3/ptr.h"
 #include "ns3/p1906-motion.h"
+#include "ns3/p1906-em-channel-table.h"
 
 namespace ns3 {
 
@@ -64,11 +65,30 @@ public:
   		                                                           Ptr<P1906MessageCarrier> message,
   		                                                           Ptr<P1906Field> field);
 
+  /**
+   * \returns true for a P1906EMMotion, false for its subclasses that do
+   * not override it
+   */
+  virtual bool IsThreadSafe (void) const;
+  virtual void PrepareLink (Ptr<P1906MessageCarrier> message, Link &link);
+  virtual void PropagateLink (Link &link) const;
+
   void SetWaveSpeed (double s);
   double GetWaveSpeed (void);
 
+  /**
+   * \brief selects how the distance is mapped to the path loss of the
+   * channel table; the Specificity components should use the same mode
+   */
+  void SetInterpolation (P1906EMChannelTable::Interpolation interpolation);
+  P1906EMChannelTable::Interpolation GetInterpolation (void) const;
+
 private:
+  void ApplyPathLoss (double distance, double *psd) const;
+
   double m_waveSpeed;
+  Ptr<const P1906EMChannelTable> m_table;
+  P1906EMChannelTable::Interpolation m_interpolation;
 };
 
 }
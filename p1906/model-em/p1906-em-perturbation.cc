@@ -36,6 +36,7 @@
 #include "p1906-em-message-carrier.h"
 #include "ns3/simulator.h"
 #include "ns3/spectrum-value.h"
+#include "p1906-em-spectrum-registry.h"
 
 namespace ns3 {
 
@@ -56,6 +57,7 @@ P1906EMPerturbation::P1906EMPerturbation ()
 P1906EMPerturbation::~P1906EMPerturbation ()
 {
   NS_LOG_FUNCTION (this);
+  m_txPsd = 0;
 }
 
 void
@@ -63,6 +65,7 @@ P1906EMPerturbation::SetPowerTransmission (double ptx)
 {
   NS_LOG_FUNCTION (this << ptx);
   m_powerTx = ptx;
+  m_txPsd = 0;
 }
 
 double
@@ -105,6 +108,7 @@ P1906EMPerturbation::SetCentralFrequency (double f)
 {
   NS_LOG_FUNCTION (this << f);
   m_centralFrequency = f;
+  m_txPsd = 0;
 }
 
 double
@@ -119,6 +123,7 @@ P1906EMPerturbation::SetBandwidth (double b)
 {
   NS_LOG_FUNCTION (this << b);
   m_bandwidth = b;
+  m_txPsd = 0;
 }
 
 double
@@ -133,6 +138,7 @@ P1906EMPerturbation::SetSubChannel (double c)
 {
   NS_LOG_FUNCTION (this << c);
   m_subChannel = c;
+  m_txPsd = 0;
 }
 
 double
@@ -155,26 +161,16 @@ P1906EMPerturbation::CreateMessageCarrier (Ptr<Packet> p)
 		  << m_pulseDuration << m_pulseInterval
 		  << duration);
 
-  //create the vector of frequencies
-  std::vector<double> freqs;
-  int nb_of_subchannels = GetBandwidth ()/GetSubChannel ();
-  double startFrequency = GetCentralFrequency () - (GetSubChannel() * nb_of_subchannels/2) + GetSubChannel()/2;
-  for (int i = 0; i < nb_of_subchannels; ++i)
+  if (m_txPsd == 0)
     {
-	  NS_LOG_FUNCTION (this << "[i,f]"<< i << startFrequency + (i*GetSubChannel ()));
-      freqs.push_back (startFrequency + (i*GetSubChannel ()));
+      Ptr<const SpectrumModel> model = P1906EMSpectrumRegistry::GetSpectrumModel (GetCentralFrequency (),
+                                                                                  GetBandwidth (),
+                                                                                  GetSubChannel ());
+      m_txPsd = P1906EMSpectrumRegistry::GetTxPsd (model, m_powerTx, GetSubChannel ());
     }
 
-  Ptr<SpectrumModel> NanoSpectrumModel = Create<SpectrumModel> (freqs);
-  Ptr<SpectrumValue> txPsd = Create <SpectrumValue> (NanoSpectrumModel);
-
-  NS_LOG_FUNCTION (this << "[ptx,numChannels]" << m_powerTx << txPsd->GetSpectrumModel ()->GetNumBands ());
-
-  double txPowerDensity = (m_powerTx / txPsd->GetSpectrumModel ()->GetNumBands ())/
-		  GetSubChannel ();
-  (*txPsd) = txPowerDensity;
-
-  NS_LOG_FUNCTION (this << "[txPsd]" << *txPsd);
+  NS_LOG_FUNCTION (this << "[ptx,numChannels]" << m_powerTx << m_txPsd->GetSpectrumModel ()->GetNumBands ());
+  NS_LOG_FUNCTION (this << "[txPsd]" << *m_txPsd);
 
   carrier->SetPulseDuration (m_pulseDuration);
   carrier->SetPulseInterval (m_pulseInterval);
@@ -182,11 +178,24 @@ P1906EMPerturbation::CreateMessageCarrier (Ptr<Packet> p)
   carrier->SetCentralFrequency (GetCentralFrequency());
   carrier->SetBandwidth (GetBandwidth());
   carrier->SetSubChannel (GetSubChannel());
-  carrier->SetSpectrumValue (txPsd);
+  carrier->SetSharedSpectrumValue (m_txPsd);
   carrier->SetStartTime (Simulator::Now ());
   carrier->SetMessage (p);
 
   return carrier;
 }
 
+uint64_t
+P1906EMPerturbation::GetChannel (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_txPsd != 0)
+    {
+      return m_txPsd->GetSpectrumModelUid ();
+    }
+  return P1906EMSpectrumRegistry::GetSpectrumModel (GetCentralFrequency (),
+                                                    GetBandwidth (),
+                                                    GetSubChannel ())->GetUid ();
+}
+
 } // namespace ns3
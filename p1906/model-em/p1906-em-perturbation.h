@@ -35,6 +35,7 @@
 #include "ns3/nstime.h"
 #include "ns3/ptr.h"
 #include "ns3/p1906-perturbation.h"
+#include <ns3/spectrum-value.h>
 
 namespace ns3 {
 
@@ -57,6 +58,13 @@ public:
 
   virtual Ptr<P1906MessageCarrier> CreateMessageCarrier (Ptr<Packet> p);
 
+  /**
+   * \returns the uid of the SpectrumModel of the transmitted PSD, which
+   * P1906EMSpectrumRegistry shares among the perturbations with the same
+   * central frequency, bandwidth and sub-channel
+   */
+  virtual uint64_t GetChannel (void);
+
   void SetPowerTransmission (double ptx);
   double GetPowerTransmission (void);
   void SetPulseDuration (Time t);
@@ -79,6 +87,12 @@ private:
   double m_centralFrequency;
   double m_bandwidth;
   double m_subChannel;
+
+  /**
+   * the interned transmitted PSD, looked up on the first transmission
+   * after any change of the parameters above
+   */
+  Ptr<const SpectrumValue> m_txPsd;
 };
 
 }
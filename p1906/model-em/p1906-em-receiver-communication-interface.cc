@@ -38,6 +38,7 @@
 #include "ns3/p1906-medium.h"
 #include "ns3/p1906-net-device.h"
 #include "ns3/p1906-motion.h"
+#include "ns3/p1906-interference.h"
 #include "p1906-em-specificity.h"
 
 
@@ -81,6 +82,8 @@ P1906EMReceiverCommunicationInterface::HandleReception (Ptr<P1906CommunicationIn
 	  //ignore the message carrier
     }
 
+  // the carrier interferes with the next ones, whether received or not
+  GetP1906Interference ()->Add (message);
 }
 
 } // namespace ns3
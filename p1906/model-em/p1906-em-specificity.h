@@ -34,8 +34,13 @@
 #include "ns3/nstime.h"
 #include "ns3/ptr.h"
 #include "ns3/p1906-specificity.h"
+#include "ns3/p1906-em-channel-table.h"
+#include "ns3/p1906-em-band-kernels.h"
+#include <vector>
 
 namespace ns3 {
+class P1906MessageCarrier;
+class SpectrumValue;
 
 /**
  * \ingroup P1906 framework
@@ -54,10 +59,130 @@ public:
   P1906EMSpecificity ();
   virtual ~P1906EMSpecificity ();
 
+  /**
+   * \brief checks the Shannon bound, with the noise of the channel table
+   * plus the PSD of the co-channel carriers still active at the receiver.
+   * The sub-band capacities are summed only until they reach the rate.
+   */
   virtual bool CheckRxCompatibility (Ptr<P1906CommunicationInterface> src, Ptr<P1906CommunicationInterface> dst, Ptr<P1906MessageCarrier> message);
 
+  /**
+   * \brief the end of the last distance bin of the channel table in which
+   * the Shannon bound holds for the transmitted PSD of the perturbation, or
+   * infinity if it holds in the last bin. The result is cached until the
+   * perturbation parameters change.
+   *
+   * The noise follows the interpolation of this component and the gain
+   * the one of the P1906EMMotion of the medium, if any. With NEAREST_BIN a
+   * bin ends halfway to the next grid distance; with LINEAR, or when the
+   * two interpolations differ, the bound is checked on the best gain and
+   * the lowest noise of each pair of adjacent bins, between which the
+   * interpolated values lie; CUBIC may overshoot the table, so the range is
+   * infinity.
+   */
+  virtual double GetMaxRange (Ptr<P1906Perturbation> perturbation);
+
+  /**
+   * \brief the channel of the Perturbation of this communication interface,
+   * since CheckRxCompatibility accepts only its central frequency, bandwidth
+   * and sub-channel
+   */
+  virtual uint64_t GetChannel (void);
+
+  /**
+   * \brief true, since the co-channel carriers active at the receiver add
+   * to the noise of CheckRxCompatibility
+   */
+  virtual bool UsesInterference (void);
+
+  /**
+   * \returns the sum of the received PSDs [W/Hz] of the co-channel carriers
+   * active at the receiver, or 0 if there is none. It is updated as the
+   * carriers start and end (see P1906Interference).
+   */
+  Ptr<const SpectrumValue> GetInterference (void);
+
+  /**
+   * \brief selects how the distance is mapped to the molecular noise of
+   * the channel table; the Motion component should use the same mode
+   */
+  void SetInterpolation (P1906EMChannelTable::Interpolation interpolation);
+  P1906EMChannelTable::Interpolation GetInterpolation (void) const;
+
+  /**
+   * \brief selects the logarithm used by the Shannon capacity, EXACT by
+   * default (see P1906EMBandKernels::Precision)
+   */
+  void SetCapacityPrecision (P1906EMBandKernels::Precision precision);
+  P1906EMBandKernels::Precision GetCapacityPrecision (void) const;
+
+  /**
+   * \brief enables a direct-mapped cache of the capacities computed by
+   * CheckRxCompatibility, with nEntries slots, or disables it with 0 (the
+   * default). The capacities are keyed on the channel table, the distance
+   * bin, the transmitted PSD and the sub-channel, so a reception that hits
+   * the cache is checked with a single comparison against the rate.
+   *
+   * The cache relies on the received PSD being the transmitted one times
+   * the gain of the bin, as computed by P1906EMMotion: it is used only when
+   * both this component and the P1906EMMotion of the medium use the
+   * LOWER_BIN interpolation, and bypassed while co-channel carriers
+   * interfere. Resizing the cache empties it and resets its counters.
+   */
+  void SetCapacityCacheSize (uint32_t nEntries);
+  uint32_t GetCapacityCacheSize (void) const;
+  uint64_t GetCapacityCacheHits (void) const;
+  uint64_t GetCapacityCacheMisses (void) const;
+
 private:
+  struct CapacityCacheEntry
+  {
+    Ptr<const P1906EMChannelTable> m_table;
+    uint32_t m_bin;
+    Ptr<const SpectrumValue> m_txPsd; // held, so that its address is not reused
+    double m_subChannel;
+    double m_efficiency; // the full sum of log2 (1 + sinr) over the sub-bands
+  };
+
+  CapacityCacheEntry* GetCapacityCacheEntry (uint32_t bin, Ptr<const SpectrumValue> txPsd, double subChannel);
+  bool IsReceivedPsdBinned (Ptr<P1906CommunicationInterface> dst);
+
+  const double* UpdateInterference (void);
+  void AddInterferer (Ptr<P1906MessageCarrier> message);
+  void RemoveInterferer (Ptr<P1906MessageCarrier> message);
+  bool IsInterferer (Ptr<P1906MessageCarrier> message);
+
+  /**
+   * \returns the interpolation of the P1906EMMotion of the medium, or the
+   * one of this component if there is none
+   */
+  P1906EMChannelTable::Interpolation GetMotionInterpolation (void);
+  double ComputeMaxRange (double powerTx, double centralFrequency, double bandwidth,
+                          double subChannel, double transmissionRate,
+                          P1906EMChannelTable::Interpolation gainInterpolation);
+
+  Ptr<const P1906EMChannelTable> m_table;
+  P1906EMChannelTable::Interpolation m_interpolation;
+  P1906EMBandKernels::Precision m_capacityPrecision;
+  std::vector<double> m_signalPower;
+  std::vector<double> m_noise;
+
+  std::vector<CapacityCacheEntry> m_capacityCache;
+  uint64_t m_capacityCacheHits;
+  uint64_t m_capacityCacheMisses;
+
+  bool m_maxRangeValid;
+  double m_maxRange;
+  double m_maxRangePowerTx;
+  double m_maxRangeCentralFrequency;
+  double m_maxRangeBandwidth;
+  double m_maxRangeSubChannel;
+  double m_maxRangeTransmissionRate;
+  P1906EMChannelTable::Interpolation m_maxRangeGainInterpolation;
 
+  bool m_interferenceConnected;
+  Ptr<SpectrumValue> m_interference;
+  uint32_t m_nInterferers;
 };
 
 }
@@ -0,0 +1,151 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+#include "ns3/log.h"
+
+#include "p1906-em-spectrum-registry.h"
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("P1906EMSpectrumRegistry");
+
+namespace {
+
+struct SpectrumModelKey
+{
+  double centralFrequency;
+  double bandwidth;
+  double subChannel;
+
+  bool operator< (const SpectrumModelKey &o) const
+  {
+    if (centralFrequency != o.centralFrequency)
+      {
+        return centralFrequency < o.centralFrequency;
+      }
+    if (bandwidth != o.bandwidth)
+      {
+        return bandwidth < o.bandwidth;
+      }
+    return subChannel < o.subChannel;
+  }
+};
+
+struct TxPsdKey
+{
+  uint32_t modelUid;
+  double powerTx;
+  double subChannel;
+
+  bool operator< (const TxPsdKey &o) const
+  {
+    if (modelUid != o.modelUid)
+      {
+        return modelUid < o.modelUid;
+      }
+    if (powerTx != o.powerTx)
+      {
+        return powerTx < o.powerTx;
+      }
+    return subChannel < o.subChannel;
+  }
+};
+
+typedef std::map<SpectrumModelKey, Ptr<const SpectrumModel> > SpectrumModels;
+typedef std::map<TxPsdKey, Ptr<SpectrumValue> > TxPsds;
+
+SpectrumModels&
+GetSpectrumModels (void)
+{
+  static SpectrumModels models;
+  return models;
+}
+
+TxPsds&
+GetTxPsds (void)
+{
+  static TxPsds psds;
+  return psds;
+}
+
+} // anonymous namespace
+
+Ptr<const SpectrumModel>
+P1906EMSpectrumRegistry::GetSpectrumModel (double centralFrequency,
+                                           double bandwidth,
+                                           double subChannel)
+{
+  SpectrumModelKey key = { centralFrequency, bandwidth, subChannel };
+  SpectrumModels::iterator it = GetSpectrumModels ().find (key);
+  if (it != GetSpectrumModels ().end ())
+    {
+      return it->second;
+    }
+
+  NS_LOG_FUNCTION ("new spectrum model [fc,bw,sub]" << centralFrequency << bandwidth << subChannel);
+
+  //create the vector of frequencies
+  std::vector<double> freqs;
+  int nb_of_subchannels = bandwidth/subChannel;
+  double startFrequency = centralFrequency - (subChannel * nb_of_subchannels/2) + subChannel/2;
+  for (int i = 0; i < nb_of_subchannels; ++i)
+    {
+      NS_LOG_FUNCTION ("[i,f]" << i << startFrequency + (i*subChannel));
+      freqs.push_back (startFrequency + (i*subChannel));
+    }
+
+  Ptr<const SpectrumModel> model = Create<SpectrumModel> (freqs);
+  GetSpectrumModels ()[key] = model;
+  return model;
+}
+
+Ptr<const SpectrumValue>
+P1906EMSpectrumRegistry::GetTxPsd (Ptr<const SpectrumModel> model,
+                                   double powerTx,
+                                   double subChannel)
+{
+  TxPsdKey key = { model->GetUid (), powerTx, subChannel };
+  TxPsds::iterator it = GetTxPsds ().find (key);
+  if (it != GetTxPsds ().end ())
+    {
+      return it->second;
+    }
+
+  Ptr<SpectrumValue> txPsd = Create <SpectrumValue> (model);
+  double txPowerDensity = (powerTx / model->GetNumBands ())/subChannel;
+  (*txPsd) = txPowerDensity;
+
+  NS_LOG_FUNCTION ("new transmitted PSD [ptx,numChannels,txPsd]" << powerTx << model->GetNumBands () << *txPsd);
+
+  GetTxPsds ()[key] = txPsd;
+  return txPsd;
+}
+
+} // namespace ns3
@@ -0,0 +1,81 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+
+#ifndef P1906_EM_SPECTRUM_REGISTRY
+#define P1906_EM_SPECTRUM_REGISTRY
+
+#include "ns3/ptr.h"
+#include <ns3/spectrum-value.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup P1906 framework
+ *
+ * \class P1906EMSpectrumRegistry
+ *
+ * \brief Process-wide registry of the spectrum models and of the
+ * transmitted PSDs used by the EM example.
+ *
+ * A SpectrumModel is created once for each (central frequency, bandwidth,
+ * sub-channel) triple, and a transmitted PSD once for each (spectrum model,
+ * transmission power) pair: carriers reference these instances instead of
+ * rebuilding them for every packet.
+ */
+
+class P1906EMSpectrumRegistry
+{
+public:
+  /**
+   * \param centralFrequency the central frequency [Hz]
+   * \param bandwidth the overall bandwidth [Hz]
+   * \param subChannel the width of a sub-band [Hz]
+   * \return the interned model made by bandwidth/subChannel sub-bands
+   * centered around centralFrequency
+   */
+  static Ptr<const SpectrumModel> GetSpectrumModel (double centralFrequency,
+                                                    double bandwidth,
+                                                    double subChannel);
+
+  /**
+   * \param model an interned spectrum model
+   * \param powerTx the transmission power [W]
+   * \param subChannel the width of a sub-band [Hz]
+   * \return the PSD spreading powerTx uniformly over the bands of the
+   * model. The instance is shared, hence read-only (Copy () it to modify
+   * it)
+   */
+  static Ptr<const SpectrumValue> GetTxPsd (Ptr<const SpectrumModel> model,
+                                      double powerTx,
+                                      double subChannel);
+};
+
+}
+
+#endif /* P1906_EM_SPECTRUM_REGISTRY */
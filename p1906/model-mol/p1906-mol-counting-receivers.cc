@@ -0,0 +1,334 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+#include "ns3/log.h"
+
+#include "p1906-mol-counting-receivers.h"
+#include "p1906-mol-particles.h"
+#include <cmath>
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("P1906MOLCountingReceivers");
+
+namespace {
+
+const uint64_t g_emptyKey = ~0ULL;
+const uint32_t g_noSlot = ~0U;
+const uint64_t g_cellMask = 0x1fffff;
+const uint64_t g_hashMultiplier = 0xff51afd7ed558ccdULL;
+
+/*
+ * the first slot of a cell; the keys of neighbouring cells differ in a few
+ * bits only, which the shift spreads before the multiplication
+ */
+inline uint32_t
+HashCell (uint64_t key, uint32_t shift)
+{
+  key ^= key >> 29;
+  return static_cast<uint32_t> ((key * g_hashMultiplier) >> shift);
+}
+
+} // namespace
+
+P1906MOLCountingReceivers::P1906MOLCountingReceivers ()
+  : m_built (false),
+    m_cellScale (0),
+    m_slotMask (0),
+    m_slotShift (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+P1906MOLCountingReceivers::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_receivers.clear ();
+  m_histograms.clear ();
+  m_built = false;
+}
+
+uint32_t
+P1906MOLCountingReceivers::Add (const Vector &center, double radius, bool absorbing)
+{
+  NS_LOG_FUNCTION (this << center << radius << absorbing);
+  Receiver receiver;
+  receiver.m_center = center;
+  receiver.m_radius = radius;
+  receiver.m_absorbing = absorbing;
+  m_receivers.push_back (receiver);
+  m_histograms.push_back (std::vector<uint32_t> ());
+  m_built = false;
+  return m_receivers.size () - 1;
+}
+
+uint32_t
+P1906MOLCountingReceivers::GetN (void) const
+{
+  return m_receivers.size ();
+}
+
+void
+P1906MOLCountingReceivers::ResetHistograms (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t r = 0; r < m_histograms.size (); r++)
+    {
+      m_histograms[r].clear ();
+    }
+}
+
+const std::vector<uint32_t>&
+P1906MOLCountingReceivers::GetHistogram (uint32_t index) const
+{
+  return m_histograms[index];
+}
+
+uint64_t
+P1906MOLCountingReceivers::GetKey (int32_t x, int32_t y, int32_t z) const
+{
+  return ((static_cast<uint64_t> (x) & g_cellMask) << 42)
+    | ((static_cast<uint64_t> (y) & g_cellMask) << 21)
+    | (static_cast<uint64_t> (z) & g_cellMask);
+}
+
+uint32_t
+P1906MOLCountingReceivers::GetSlot (uint64_t key) const
+{
+  uint32_t slot = HashCell (key, m_slotShift);
+  while (m_slotKeys[slot] != key)
+    {
+      if (m_slotKeys[slot] == g_emptyKey)
+        {
+          return g_noSlot;
+        }
+      slot = (slot + 1) & m_slotMask;
+    }
+  return slot;
+}
+
+void
+P1906MOLCountingReceivers::Build (const Vector &origin)
+{
+  NS_LOG_FUNCTION (this << origin);
+  uint32_t n = m_receivers.size ();
+  m_origin = origin;
+  m_x.resize (n);
+  m_y.resize (n);
+  m_z.resize (n);
+  m_radius2.resize (n);
+
+  double maxRadius = 0;
+  for (uint32_t r = 0; r < n; r++)
+    {
+      maxRadius = std::max (maxRadius, m_receivers[r].m_radius);
+    }
+  double cellSize = (maxRadius > 0) ? 2 * maxRadius : 1;
+  m_cellScale = 1. / cellSize;
+
+  // the cells overlapped by each sphere, as (key, receiver) pairs
+  std::vector<std::pair<uint64_t, uint32_t> > entries;
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      m_min[i] = HUGE_VALF;
+      m_max[i] = -HUGE_VALF;
+    }
+  for (uint32_t r = 0; r < n; r++)
+    {
+      const Receiver &receiver = m_receivers[r];
+      float center[3];
+      center[0] = m_x[r] = receiver.m_center.x - origin.x;
+      center[1] = m_y[r] = receiver.m_center.y - origin.y;
+      center[2] = m_z[r] = receiver.m_center.z - origin.z;
+      m_radius2[r] = receiver.m_radius * receiver.m_radius;
+      int32_t low[3];
+      int32_t high[3];
+      for (uint32_t i = 0; i < 3; i++)
+        {
+          m_min[i] = std::min (m_min[i], static_cast<float> (center[i] - receiver.m_radius));
+          m_max[i] = std::max (m_max[i], static_cast<float> (center[i] + receiver.m_radius));
+          low[i] = static_cast<int32_t> (std::floor ((center[i] - receiver.m_radius) * m_cellScale));
+          high[i] = static_cast<int32_t> (std::floor ((center[i] + receiver.m_radius) * m_cellScale));
+        }
+      for (int32_t x = low[0]; x <= high[0]; x++)
+        {
+          for (int32_t y = low[1]; y <= high[1]; y++)
+            {
+              for (int32_t z = low[2]; z <= high[2]; z++)
+                {
+                  entries.push_back (std::make_pair (GetKey (x, y, z), r));
+                }
+            }
+        }
+    }
+  std::sort (entries.begin (), entries.end ());
+
+  // open addressing, with at least four times as many slots as cells, so
+  // that most lookups of an empty cell stop at their first slot
+  uint32_t nSlots = 2;
+  m_slotShift = 63;
+  while (nSlots < 4 * entries.size ())
+    {
+      nSlots *= 2;
+      m_slotShift--;
+    }
+  m_slotMask = nSlots - 1;
+  m_slotKeys.assign (nSlots, g_emptyKey);
+  m_slotBegin.assign (nSlots, 0);
+  m_slotEnd.assign (nSlots, 0);
+  m_cellReceivers.resize (entries.size ());
+  for (uint32_t e = 0; e < entries.size (); e++)
+    {
+      m_cellReceivers[e] = entries[e].second;
+      if (e > 0 && entries[e].first == entries[e - 1].first)
+        {
+          continue;
+        }
+      uint32_t slot = HashCell (entries[e].first, m_slotShift);
+      while (m_slotKeys[slot] != g_emptyKey)
+        {
+          slot = (slot + 1) & m_slotMask;
+        }
+      m_slotKeys[slot] = entries[e].first;
+      m_slotBegin[slot] = e;
+      uint32_t end = e + 1;
+      while (end < entries.size () && entries[end].first == entries[e].first)
+        {
+          end++;
+        }
+      m_slotEnd[slot] = end;
+    }
+  m_built = true;
+  NS_LOG_FUNCTION (this << "[receivers,cellSize,cells,slots]" << n << cellSize << entries.size () << nSlots);
+}
+
+void
+P1906MOLCountingReceivers::Observe (P1906MOLParticles &particles, uint32_t bin)
+{
+  NS_LOG_FUNCTION (this << bin);
+  uint32_t n = m_receivers.size ();
+  if (n == 0)
+    {
+      return;
+    }
+  Vector origin = particles.GetOrigin ();
+  if (!m_built || origin.x != m_origin.x || origin.y != m_origin.y || origin.z != m_origin.z)
+    {
+      Build (origin);
+    }
+
+  uint32_t nChunks = particles.GetNChunks ();
+  m_hits.assign (nChunks * n, 0);
+  // the members the pass reads, copied so that the stores to the molecules
+  // can not alias them
+  const float min0 = m_min[0], min1 = m_min[1], min2 = m_min[2];
+  const float max0 = m_max[0], max1 = m_max[1], max2 = m_max[2];
+  const float scale = m_cellScale;
+  const float *cx = &m_x[0];
+  const float *cy = &m_y[0];
+  const float *cz = &m_z[0];
+  const float *radius2 = &m_radius2[0];
+  const uint32_t *cellReceivers = &m_cellReceivers[0];
+  const uint32_t *slotBegin = &m_slotBegin[0];
+  const uint32_t *slotEnd = &m_slotEnd[0];
+  const Receiver *receivers = &m_receivers[0];
+  const P1906MOLCountingReceivers *index = this;
+  uint32_t *hits = &m_hits[0];
+  particles.Visit ([=] (uint32_t chunk, float *x, float *y, float *z, uint32_t nMolecules) -> uint32_t
+    {
+      uint32_t *chunkHits = hits + chunk * n;
+      uint32_t kept = 0;
+      for (uint32_t i = 0; i < nMolecules; i++)
+        {
+          float px = x[i];
+          float py = y[i];
+          float pz = z[i];
+          bool absorbed = false;
+          // bitwise tests of the bounding box, since most molecules miss it
+          if ((px >= min0) & (px <= max0) & (py >= min1) & (py <= max1) & (pz >= min2) & (pz <= max2))
+            {
+              uint64_t key = index->GetKey (static_cast<int32_t> (std::floor (px * scale)),
+                                            static_cast<int32_t> (std::floor (py * scale)),
+                                            static_cast<int32_t> (std::floor (pz * scale)));
+              uint32_t slot = index->GetSlot (key);
+              if (slot != g_noSlot)
+                {
+                  for (uint32_t k = slotBegin[slot]; k < slotEnd[slot]; k++)
+                    {
+                      uint32_t r = cellReceivers[k];
+                      float dx = px - cx[r];
+                      float dy = py - cy[r];
+                      float dz = pz - cz[r];
+                      if (dx * dx + dy * dy + dz * dz > radius2[r])
+                        {
+                          continue;
+                        }
+                      // a molecule is absorbed once, by the first absorbing receiver
+                      bool absorbing = receivers[r].m_absorbing;
+                      if (!(absorbing && absorbed))
+                        {
+                          chunkHits[r]++;
+                        }
+                      absorbed = absorbed || absorbing;
+                    }
+                }
+            }
+          if (absorbed)
+            {
+              continue;
+            }
+          if (kept != i)
+            {
+              x[kept] = px;
+              y[kept] = py;
+              z[kept] = pz;
+            }
+          kept++;
+        }
+      return kept;
+    });
+
+  for (uint32_t r = 0; r < n; r++)
+    {
+      uint32_t total = 0;
+      for (uint32_t chunk = 0; chunk < nChunks; chunk++)
+        {
+          total += m_hits[chunk * n + r];
+        }
+      std::vector<uint32_t> &histogram = m_histograms[r];
+      if (histogram.size () <= bin)
+        {
+          histogram.resize (bin + 1, 0);
+        }
+      histogram[bin] += total;
+    }
+}
+
+} // namespace ns3
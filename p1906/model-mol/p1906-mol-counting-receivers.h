@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+#ifndef P1906_MOL_COUNTING_RECEIVERS
+#define P1906_MOL_COUNTING_RECEIVERS
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/vector.h"
+
+namespace ns3 {
+
+class P1906MOLParticles;
+
+/**
+ * \ingroup P1906 framework
+ *
+ * \class P1906MOLCountingReceivers
+ *
+ * \brief Spherical receiver volumes counting the molecules of a release of
+ * P1906MOLParticles, used by the particle mode of P1906MOLMotion.
+ *
+ * The spheres are indexed by a spatial hash of cubic cells, twice as large
+ * as the largest radius, that maps each cell to the spheres overlapping
+ * it, so that Observe resolves the hits of all the receivers in a single
+ * pass over the molecules, testing each of them against the few spheres of
+ * its cell only.
+ *
+ * Each receiver keeps a histogram of arrivals per time bin. A passive
+ * receiver counts the molecules within its volume at each observation,
+ * whereas an absorbing one counts a molecule once, when it enters the
+ * volume, and removes it from the release, so that no other receiver
+ * counts it afterwards.
+ */
+
+class P1906MOLCountingReceivers
+{
+public:
+  P1906MOLCountingReceivers ();
+
+  /**
+   * \brief removes the receivers
+   */
+  void Clear (void);
+  /**
+   * \param center the position of the receiver
+   * \param radius the radius [m] of its volume
+   * \param absorbing whether it removes the molecules it counts
+   * \returns the index of the receiver
+   */
+  uint32_t Add (const Vector &center, double radius, bool absorbing);
+  uint32_t GetN (void) const;
+
+  /**
+   * \brief empties the histograms of the receivers, e.g., at a new release
+   */
+  void ResetHistograms (void);
+  /**
+   * \brief adds the molecules of particles within each receiver to the bin
+   * of its histogram, and removes those an absorbing receiver counted
+   */
+  void Observe (P1906MOLParticles &particles, uint32_t bin);
+  /**
+   * \returns the arrivals per bin of the receiver of index
+   */
+  const std::vector<uint32_t>& GetHistogram (uint32_t index) const;
+
+private:
+  /*
+   * \brief indexes the receivers in the frame of the offsets of the
+   * molecules, i.e., relative to origin
+   */
+  void Build (const Vector &origin);
+  uint32_t GetSlot (uint64_t key) const;
+  uint64_t GetKey (int32_t x, int32_t y, int32_t z) const;
+
+  struct Receiver
+  {
+    Vector m_center;
+    double m_radius;
+    bool m_absorbing;
+  };
+  std::vector<Receiver> m_receivers;
+  std::vector<std::vector<uint32_t> > m_histograms;
+
+  // the spatial hash, valid while m_built holds and the origin is unchanged
+  bool m_built;
+  Vector m_origin;
+  float m_cellScale;
+  float m_min[3];
+  float m_max[3];
+  std::vector<float> m_x;
+  std::vector<float> m_y;
+  std::vector<float> m_z;
+  std::vector<float> m_radius2;
+  std::vector<uint64_t> m_slotKeys;
+  std::vector<uint32_t> m_slotBegin;
+  std::vector<uint32_t> m_slotEnd;
+  uint32_t m_slotMask;
+  uint32_t m_slotShift;
+  std::vector<uint32_t> m_cellReceivers;
+
+  // the hits of an observation, per chunk of molecules and receiver
+  std::vector<uint32_t> m_hits;
+};
+
+}
+
+#endif /* P1906_MOL_COUNTING_RECEIVERS */
@@ -31,11 +31,20 @@
 
 #include "p1906-mol-field.h"
 #include "ns3/p1906-field.h"
+#include <cmath>
+#include <algorithm>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("P1906MOLField");
 
+namespace {
+
+// the samples of GetMeanVelocity along the longest segments
+const uint32_t g_maxMeanVelocitySamples = 1024;
+
+} // namespace
+
 TypeId P1906MOLField::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::P1906MOLField")
@@ -54,4 +63,107 @@ P1906MOLField::~P1906MOLField ()
   NS_LOG_FUNCTION (this);
 }
 
+bool
+P1906MOLField::IsEmpty (void) const
+{
+  return GetInstanceTypeId () == P1906MOLField::GetTypeId () && m_flowGrid == 0;
+}
+
+void
+P1906MOLField::SetFlowGrid (Ptr<const P1906MOLFlowGrid> grid)
+{
+  NS_LOG_FUNCTION (this << grid);
+  m_flowGrid = grid;
+}
+
+Ptr<const P1906MOLFlowGrid>
+P1906MOLField::GetFlowGrid (void) const
+{
+  return m_flowGrid;
+}
+
+void
+P1906MOLField::SetUniformVelocity (const Vector &velocity)
+{
+  NS_LOG_FUNCTION (this << velocity);
+  m_flowGrid = P1906MOLFlowGrid::CreateUniform (velocity);
+}
+
+bool
+P1906MOLField::LoadFlowGrid (std::string fileName)
+{
+  NS_LOG_FUNCTION (this << fileName);
+  Ptr<const P1906MOLFlowGrid> grid = P1906MOLFlowGrid::Load (fileName);
+  if (grid == 0)
+    {
+      return false;
+    }
+  m_flowGrid = grid;
+  return true;
+}
+
+Vector
+P1906MOLField::GetVelocity (const Vector &position) const
+{
+  if (m_flowGrid == 0)
+    {
+      return Vector (0, 0, 0);
+    }
+  return m_flowGrid->GetVelocity (position);
+}
+
+Vector
+P1906MOLField::GetMeanVelocity (const Vector &from, const Vector &to) const
+{
+  NS_LOG_FUNCTION (this);
+  if (m_flowGrid == 0)
+    {
+      return Vector (0, 0, 0);
+    }
+  Vector spacing = m_flowGrid->GetSpacing ();
+  double step = std::min (spacing.x, std::min (spacing.y, spacing.z)) / 2;
+  double n = std::min (ceil (CalculateDistance (from, to) / step), (double) g_maxMeanVelocitySamples);
+  uint32_t nSamples = std::max (static_cast<uint32_t> (n), 1U);
+
+  // the midpoints of nSamples equal parts of the segment
+  Vector mean (0, 0, 0);
+  for (uint32_t i = 0; i < nSamples; i++)
+    {
+      double a = (i + 0.5) / nSamples;
+      Vector velocity = m_flowGrid->GetVelocity (Vector (from.x + a * (to.x - from.x),
+                                                         from.y + a * (to.y - from.y),
+                                                         from.z + a * (to.z - from.z)));
+      mean.x += velocity.x / nSamples;
+      mean.y += velocity.y / nSamples;
+      mean.z += velocity.z / nSamples;
+    }
+  return mean;
+}
+
+double
+P1906MOLField::GetPeakTime (double diffusion, double distance, const Vector &velocity)
+{
+  double speed2 = velocity.x * velocity.x + velocity.y * velocity.y + velocity.z * velocity.z;
+  if (speed2 == 0)
+    {
+      return pow(distance,2)/(diffusion*6);
+    }
+  /*
+   * the concentration N / (4 pi D t)^(3/2) e^(-|r - v t|^2 / (4 D t)) peaks
+   * when v^2 t^2 + 6 D t - d^2 = 0, whatever the direction of v
+   */
+  double d = diffusion;
+  return pow(distance,2)/(3*d + sqrt (9*d*d + speed2*pow(distance,2)));
+}
+
+double
+P1906MOLField::GetConcentration (double diffusion, const Vector &displacement, const Vector &velocity, double t)
+{
+  double dx = displacement.x - velocity.x * t;
+  double dy = displacement.y - velocity.y * t;
+  double dz = displacement.z - velocity.z * t;
+  double spread = 4 * diffusion * t;
+  return exp (-(dx * dx + dy * dy + dz * dz) / spread) / pow(M_PI * spread, 1.5);
+}
+
 } // namespace ns3
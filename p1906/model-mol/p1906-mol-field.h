@@ -33,7 +33,10 @@
 #include "ns3/object.h"
 #include "ns3/nstime.h"
 #include "ns3/ptr.h"
+#include "ns3/vector.h"
 #include "ns3/p1906-field.h"
+#include "ns3/p1906-mol-flow-grid.h"
+#include <string>
 
 namespace ns3 {
 
@@ -44,6 +47,10 @@ namespace ns3 {
  *
  * \brief Base class implementing the Field component of
  * the P1906 framework, dedicated to the MOLECULAR Example
+ *
+ * The field may hold the velocity of the medium as a P1906MOLFlowGrid, in
+ * which case P1906MOLMotion adds its drift to the diffusion of the
+ * molecules. Without a flow, the medium is still.
  */
 
 class P1906MOLField : public P1906Field
@@ -54,6 +61,54 @@ public:
   P1906MOLField ();
   virtual ~P1906MOLField ();
 
+  /**
+   * \returns true for a P1906MOLField without flow grid, false for its
+   * subclasses that do not override it
+   */
+  virtual bool IsEmpty (void) const;
+
+  /**
+   * \param grid the velocity of the medium, or 0 for a still medium
+   */
+  void SetFlowGrid (Ptr<const P1906MOLFlowGrid> grid);
+  Ptr<const P1906MOLFlowGrid> GetFlowGrid (void) const;
+  /**
+   * \brief sets a flow of the same velocity [m/s] everywhere
+   */
+  void SetUniformVelocity (const Vector &velocity);
+  /**
+   * \brief maps the flow grid of a file written by P1906MOLFlowGrid::Write
+   * \returns whether the file is a valid flow grid, the flow being
+   * unchanged otherwise
+   */
+  bool LoadFlowGrid (std::string fileName);
+
+  /**
+   * \returns the velocity [m/s] of the medium at position
+   */
+  Vector GetVelocity (const Vector &position) const;
+  /**
+   * \returns the velocity [m/s] of the medium averaged along the segment
+   * from one position to the other, sampled every half grid spacing at
+   * most
+   */
+  Vector GetMeanVelocity (const Vector &from, const Vector &to) const;
+
+  /**
+   * \returns the peak time [s] of the concentration at distance [m] from a
+   * release diffusing with coefficient diffusion [m^2/s] and drifting at
+   * velocity [m/s], d^2 / (6 D) in a still medium
+   */
+  static double GetPeakTime (double diffusion, double distance, const Vector &velocity);
+  /**
+   * \returns the concentration [1/m^3] at displacement [m] from a release
+   * of one molecule diffusing with coefficient diffusion [m^2/s] and
+   * drifting at velocity [m/s], t seconds after the release
+   */
+  static double GetConcentration (double diffusion, const Vector &displacement, const Vector &velocity, double t);
+
+private:
+  Ptr<const P1906MOLFlowGrid> m_flowGrid;
 };
 
 }
@@ -0,0 +1,503 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+#include "ns3/log.h"
+
+#include "p1906-mol-flow-grid.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined (__AVX2__)
+#include <immintrin.h>
+#elif defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("P1906MOLFlowGrid");
+
+namespace {
+
+/*
+ * A brick holds g_brickPoints^3 points of g_pointFloats floats, ordered by
+ * x, then y, then z, and covers g_brickCells^3 cells; the corners of a cell
+ * are then g_dx, g_dy and g_dz floats apart.
+ */
+const uint32_t g_brickPoints = 8;
+const uint32_t g_brickCells = g_brickPoints - 1;
+const uint32_t g_pointFloats = 4;
+const uint32_t g_dx = g_pointFloats;
+const uint32_t g_dy = g_brickPoints * g_dx;
+const uint32_t g_dz = g_brickPoints * g_dy;
+const uint32_t g_brickFloats = g_brickPoints * g_dz;
+
+const char g_fileMagic[8] = { 'P', '1', '9', '0', '6', 'M', 'F', 'G' };
+const uint32_t g_fileVersion = 1;
+const uint32_t g_fileByteOrder = 0x01020304;
+const uint64_t g_fileAlignment = 64;
+
+enum FileUnit
+{
+  UNIT_METER = 1,
+  UNIT_METER_PER_SECOND = 2
+};
+
+struct FileHeader
+{
+  char m_magic[8];
+  uint32_t m_version;
+  uint32_t m_headerSize;
+  uint32_t m_byteOrder;
+  uint32_t m_nx;
+  uint32_t m_ny;
+  uint32_t m_nz;
+  uint32_t m_lengthUnit;
+  uint32_t m_velocityUnit;
+  double m_origin[3];
+  double m_spacing[3];
+  uint64_t m_bricksOffset;
+  uint64_t m_fileSize;
+};
+
+uint64_t
+Align (uint64_t offset)
+{
+  return (offset + g_fileAlignment - 1) / g_fileAlignment * g_fileAlignment;
+}
+
+uint32_t
+GetNBricks (uint32_t n)
+{
+  return (n - 1 + g_brickCells - 1) / g_brickCells;
+}
+
+/*
+ * the velocity at the weights (fx, fy, fz) of the cell whose first corner
+ * is corner; the last float of velocity is padding
+ */
+inline void
+Trilinear (const float *corner, const float *weights, float *velocity)
+{
+#if defined (__AVX2__)
+  // the two corners along x of an edge are a single load
+  __m256 c00 = _mm256_loadu_ps (corner);
+  __m256 c10 = _mm256_loadu_ps (corner + g_dy);
+  __m256 c01 = _mm256_loadu_ps (corner + g_dz);
+  __m256 c11 = _mm256_loadu_ps (corner + g_dy + g_dz);
+  __m256 fy = _mm256_set1_ps (weights[1]);
+  __m256 fz = _mm256_set1_ps (weights[2]);
+  __m256 c0 = _mm256_add_ps (c00, _mm256_mul_ps (fy, _mm256_sub_ps (c10, c00)));
+  __m256 c1 = _mm256_add_ps (c01, _mm256_mul_ps (fy, _mm256_sub_ps (c11, c01)));
+  __m256 c = _mm256_add_ps (c0, _mm256_mul_ps (fz, _mm256_sub_ps (c1, c0)));
+  __m128 low = _mm256_castps256_ps128 (c);
+  __m128 high = _mm256_extractf128_ps (c, 1);
+  _mm_storeu_ps (velocity, _mm_add_ps (low, _mm_mul_ps (_mm_set1_ps (weights[0]), _mm_sub_ps (high, low))));
+#elif defined (__SSE2__)
+  __m128 fx = _mm_set1_ps (weights[0]);
+  __m128 fy = _mm_set1_ps (weights[1]);
+  __m128 fz = _mm_set1_ps (weights[2]);
+  __m128 c[4];
+  for (uint32_t edge = 0; edge < 4; edge++)
+    {
+      const float *p = corner + (edge & 1) * g_dy + (edge >> 1) * g_dz;
+      __m128 c0 = _mm_loadu_ps (p);
+      c[edge] = _mm_add_ps (c0, _mm_mul_ps (fx, _mm_sub_ps (_mm_loadu_ps (p + g_dx), c0)));
+    }
+  __m128 c0 = _mm_add_ps (c[0], _mm_mul_ps (fy, _mm_sub_ps (c[1], c[0])));
+  __m128 c1 = _mm_add_ps (c[2], _mm_mul_ps (fy, _mm_sub_ps (c[3], c[2])));
+  _mm_storeu_ps (velocity, _mm_add_ps (c0, _mm_mul_ps (fz, _mm_sub_ps (c1, c0))));
+#else
+  for (uint32_t axis = 0; axis < 3; axis++)
+    {
+      const float *p = corner + axis;
+      float c00 = p[0] + weights[0] * (p[g_dx] - p[0]);
+      float c10 = p[g_dy] + weights[0] * (p[g_dy + g_dx] - p[g_dy]);
+      float c01 = p[g_dz] + weights[0] * (p[g_dz + g_dx] - p[g_dz]);
+      float c11 = p[g_dz + g_dy] + weights[0] * (p[g_dz + g_dy + g_dx] - p[g_dz + g_dy]);
+      float c0 = c00 + weights[1] * (c10 - c00);
+      float c1 = c01 + weights[1] * (c11 - c01);
+      velocity[axis] = c0 + weights[2] * (c1 - c0);
+    }
+#endif
+}
+
+/*
+ * the cell of a position p [grid units] along an axis of n points, and
+ * the weight of its upper corner, p being clamped to the grid
+ */
+inline uint32_t
+Locate (float p, uint32_t n, float &weight)
+{
+  p = std::min (std::max (0.f, p), static_cast<float> (n - 1));
+  int32_t cell = static_cast<int32_t> (std::min (p, static_cast<float> (n - 2)));
+  weight = p - cell;
+  return cell;
+}
+
+#if defined (__AVX2__)
+const uint32_t g_locateWidth = 8;
+#elif defined (__SSE2__)
+const uint32_t g_locateWidth = 4;
+#endif
+
+#if defined (__AVX2__) || defined (__SSE2__)
+/*
+ * Locate on the g_locateWidth positions shift + scale * offsets
+ */
+inline void
+LocateSimd (const float *offsets, float scale, float shift, uint32_t n, int32_t *cells, float *weights)
+{
+#if defined (__AVX2__)
+  __m256 p = _mm256_add_ps (_mm256_mul_ps (_mm256_loadu_ps (offsets), _mm256_set1_ps (scale)), _mm256_set1_ps (shift));
+  p = _mm256_min_ps (_mm256_max_ps (p, _mm256_setzero_ps ()), _mm256_set1_ps (n - 1));
+  __m256i cell = _mm256_cvttps_epi32 (_mm256_min_ps (p, _mm256_set1_ps (n - 2)));
+  _mm256_storeu_si256 (reinterpret_cast<__m256i*> (cells), cell);
+  _mm256_storeu_ps (weights, _mm256_sub_ps (p, _mm256_cvtepi32_ps (cell)));
+#else
+  __m128 p = _mm_add_ps (_mm_mul_ps (_mm_loadu_ps (offsets), _mm_set1_ps (scale)), _mm_set1_ps (shift));
+  p = _mm_min_ps (_mm_max_ps (p, _mm_setzero_ps ()), _mm_set1_ps (n - 1));
+  __m128i cell = _mm_cvttps_epi32 (_mm_min_ps (p, _mm_set1_ps (n - 2)));
+  _mm_storeu_si128 (reinterpret_cast<__m128i*> (cells), cell);
+  _mm_storeu_ps (weights, _mm_sub_ps (p, _mm_cvtepi32_ps (cell)));
+#endif
+}
+#endif
+
+}
+
+Ptr<const P1906MOLFlowGrid>
+P1906MOLFlowGrid::Create (const Vector &origin, const Vector &spacing,
+                          uint32_t nx, uint32_t ny, uint32_t nz,
+                          const float *velocities)
+{
+  NS_LOG_FUNCTION ("[nx,ny,nz]" << nx << ny << nz);
+  NS_ASSERT (nx >= 2 && ny >= 2 && nz >= 2);
+  NS_ASSERT (spacing.x > 0 && spacing.y > 0 && spacing.z > 0);
+  P1906MOLFlowGrid *grid = new P1906MOLFlowGrid (origin, spacing, nx, ny, nz, 0);
+
+  // the points beyond the grid, in the last bricks, repeat its last ones
+  float *brick = &grid->m_storage[0];
+  for (uint32_t bz = 0; bz < grid->m_nBricksZ; bz++)
+    {
+      for (uint32_t by = 0; by < grid->m_nBricksY; by++)
+        {
+          for (uint32_t bx = 0; bx < grid->m_nBricksX; bx++, brick += g_brickFloats)
+            {
+              float *point = brick;
+              for (uint32_t lz = 0; lz < g_brickPoints; lz++)
+                {
+                  uint64_t k = std::min (bz * g_brickCells + lz, nz - 1);
+                  for (uint32_t ly = 0; ly < g_brickPoints; ly++)
+                    {
+                      uint64_t j = std::min (by * g_brickCells + ly, ny - 1);
+                      for (uint32_t lx = 0; lx < g_brickPoints; lx++, point += g_pointFloats)
+                        {
+                          uint64_t i = std::min (bx * g_brickCells + lx, nx - 1);
+                          const float *velocity = velocities + 3 * ((k * ny + j) * nx + i);
+                          point[0] = velocity[0];
+                          point[1] = velocity[1];
+                          point[2] = velocity[2];
+                          point[3] = 0;
+                        }
+                    }
+                }
+            }
+        }
+    }
+  return Ptr<const P1906MOLFlowGrid> (grid, false);
+}
+
+Ptr<const P1906MOLFlowGrid>
+P1906MOLFlowGrid::CreateUniform (const Vector &velocity)
+{
+  NS_LOG_FUNCTION (velocity);
+  float velocities[3 * 8];
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      velocities[3 * i] = velocity.x;
+      velocities[3 * i + 1] = velocity.y;
+      velocities[3 * i + 2] = velocity.z;
+    }
+  return Create (Vector (0, 0, 0), Vector (1, 1, 1), 2, 2, 2, velocities);
+}
+
+Ptr<const P1906MOLFlowGrid>
+P1906MOLFlowGrid::Load (std::string fileName)
+{
+  NS_LOG_FUNCTION (fileName);
+  int fd = open (fileName.c_str (), O_RDONLY);
+  if (fd < 0)
+    {
+      NS_LOG_WARN ("cannot open " << fileName);
+      return 0;
+    }
+  struct stat status;
+  if (fstat (fd, &status) != 0 || status.st_size < (off_t) sizeof (FileHeader))
+    {
+      NS_LOG_WARN ("cannot read the header of " << fileName);
+      close (fd);
+      return 0;
+    }
+  uint64_t size = status.st_size;
+  void *mapping = mmap (0, size, PROT_READ, MAP_SHARED, fd, 0);
+  close (fd);
+  if (mapping == MAP_FAILED)
+    {
+      NS_LOG_WARN ("cannot map " << fileName);
+      return 0;
+    }
+
+  const char *base = static_cast<const char*> (mapping);
+  FileHeader header;
+  std::memcpy (&header, base, sizeof (header));
+  bool valid = std::memcmp (header.m_magic, g_fileMagic, sizeof (g_fileMagic)) == 0 &&
+    header.m_version == g_fileVersion &&
+    header.m_headerSize == sizeof (FileHeader) &&
+    header.m_byteOrder == g_fileByteOrder &&
+    header.m_nx >= 2 && header.m_ny >= 2 && header.m_nz >= 2 &&
+    header.m_lengthUnit == UNIT_METER && header.m_velocityUnit == UNIT_METER_PER_SECOND &&
+    header.m_spacing[0] > 0 && header.m_spacing[1] > 0 && header.m_spacing[2] > 0 &&
+    header.m_fileSize == size &&
+    header.m_bricksOffset % sizeof (float) == 0 && header.m_bricksOffset >= sizeof (FileHeader) &&
+    header.m_bricksOffset <= size;
+  if (valid)
+    {
+      uint64_t nFloats = (uint64_t) GetNBricks (header.m_nx) * GetNBricks (header.m_ny) * GetNBricks (header.m_nz) * g_brickFloats;
+      valid = nFloats <= (size - header.m_bricksOffset) / sizeof (float);
+    }
+  if (!valid)
+    {
+      NS_LOG_WARN (fileName << " is not a valid version " << g_fileVersion << " flow grid");
+      munmap (mapping, size);
+      return 0;
+    }
+
+  P1906MOLFlowGrid *grid =
+    new P1906MOLFlowGrid (Vector (header.m_origin[0], header.m_origin[1], header.m_origin[2]),
+                          Vector (header.m_spacing[0], header.m_spacing[1], header.m_spacing[2]),
+                          header.m_nx, header.m_ny, header.m_nz,
+                          reinterpret_cast<const float*> (base + header.m_bricksOffset));
+  grid->m_mapping = mapping;
+  grid->m_mappingSize = size;
+  return Ptr<const P1906MOLFlowGrid> (grid, false);
+}
+
+bool
+P1906MOLFlowGrid::Write (std::string fileName) const
+{
+  NS_LOG_FUNCTION (this << fileName);
+  uint64_t nFloats = (uint64_t) m_nBricksX * m_nBricksY * m_nBricksZ * g_brickFloats;
+
+  FileHeader header;
+  std::memset (&header, 0, sizeof (header));
+  std::memcpy (header.m_magic, g_fileMagic, sizeof (g_fileMagic));
+  header.m_version = g_fileVersion;
+  header.m_headerSize = sizeof (FileHeader);
+  header.m_byteOrder = g_fileByteOrder;
+  header.m_nx = m_nx;
+  header.m_ny = m_ny;
+  header.m_nz = m_nz;
+  header.m_lengthUnit = UNIT_METER;
+  header.m_velocityUnit = UNIT_METER_PER_SECOND;
+  header.m_origin[0] = m_origin.x;
+  header.m_origin[1] = m_origin.y;
+  header.m_origin[2] = m_origin.z;
+  header.m_spacing[0] = m_spacing.x;
+  header.m_spacing[1] = m_spacing.y;
+  header.m_spacing[2] = m_spacing.z;
+  header.m_bricksOffset = Align (sizeof (FileHeader));
+  header.m_fileSize = header.m_bricksOffset + nFloats * sizeof (float);
+
+  std::ofstream file (fileName.c_str (), std::ios::binary | std::ios::trunc);
+  file.write (reinterpret_cast<const char*> (&header), sizeof (header));
+  const char padding[g_fileAlignment] = { 0 };
+  file.write (padding, header.m_bricksOffset - sizeof (header));
+  file.write (reinterpret_cast<const char*> (m_bricks), nFloats * sizeof (float));
+  file.close ();
+  if (!file)
+    {
+      NS_LOG_WARN ("cannot write " << fileName);
+      return false;
+    }
+  return true;
+}
+
+P1906MOLFlowGrid::P1906MOLFlowGrid (const Vector &origin, const Vector &spacing,
+                                    uint32_t nx, uint32_t ny, uint32_t nz,
+                                    const float *bricks)
+  : m_origin (origin),
+    m_spacing (spacing),
+    m_nx (nx),
+    m_ny (ny),
+    m_nz (nz),
+    m_nBricksX (GetNBricks (nx)),
+    m_nBricksY (GetNBricks (ny)),
+    m_nBricksZ (GetNBricks (nz)),
+    m_bricks (bricks),
+    m_mapping (0),
+    m_mappingSize (0)
+{
+  NS_LOG_FUNCTION (this << "[nx,ny,nz]" << nx << ny << nz);
+  if (m_bricks == 0)
+    {
+      m_storage.resize ((uint64_t) m_nBricksX * m_nBricksY * m_nBricksZ * g_brickFloats);
+      m_bricks = &m_storage[0];
+    }
+
+  // a cell lies in the brick of index cell / g_brickCells along each axis
+  uint32_t nCells[3] = { nx - 1, ny - 1, nz - 1 };
+  uint64_t brickStride[3] = { g_brickFloats,
+                              (uint64_t) m_nBricksX * g_brickFloats,
+                              (uint64_t) m_nBricksX * m_nBricksY * g_brickFloats };
+  uint64_t pointStride[3] = { g_dx, g_dy, g_dz };
+  for (uint32_t axis = 0; axis < 3; axis++)
+    {
+      for (uint32_t cell = 0; cell < nCells[axis]; cell++)
+        {
+          m_cellOffsets.push_back (cell / g_brickCells * brickStride[axis] + cell % g_brickCells * pointStride[axis]);
+        }
+    }
+  m_cellOffsetsX = &m_cellOffsets[0];
+  m_cellOffsetsY = m_cellOffsetsX + nCells[0];
+  m_cellOffsetsZ = m_cellOffsetsY + nCells[1];
+}
+
+P1906MOLFlowGrid::~P1906MOLFlowGrid ()
+{
+  NS_LOG_FUNCTION (this);
+  if (m_mapping != 0)
+    {
+      munmap (m_mapping, m_mappingSize);
+    }
+}
+
+Vector
+P1906MOLFlowGrid::GetOrigin (void) const
+{
+  return m_origin;
+}
+
+Vector
+P1906MOLFlowGrid::GetSpacing (void) const
+{
+  return m_spacing;
+}
+
+uint32_t
+P1906MOLFlowGrid::GetNx (void) const
+{
+  return m_nx;
+}
+
+uint32_t
+P1906MOLFlowGrid::GetNy (void) const
+{
+  return m_ny;
+}
+
+uint32_t
+P1906MOLFlowGrid::GetNz (void) const
+{
+  return m_nz;
+}
+
+inline uint64_t
+P1906MOLFlowGrid::FindCell (float u, float v, float w, float *weights) const
+{
+  return m_cellOffsetsX[Locate (u, m_nx, weights[0])] +
+    m_cellOffsetsY[Locate (v, m_ny, weights[1])] +
+    m_cellOffsetsZ[Locate (w, m_nz, weights[2])];
+}
+
+Vector
+P1906MOLFlowGrid::GetVelocity (const Vector &position) const
+{
+  float weights[3];
+  uint64_t corner = FindCell ((position.x - m_origin.x) / m_spacing.x,
+                              (position.y - m_origin.y) / m_spacing.y,
+                              (position.z - m_origin.z) / m_spacing.z,
+                              weights);
+  float velocity[g_pointFloats];
+  Trilinear (m_bricks + corner, weights, velocity);
+  return Vector (velocity[0], velocity[1], velocity[2]);
+}
+
+void
+P1906MOLFlowGrid::Interpolate (const Vector &origin, const float *x, const float *y, const float *z, uint32_t n,
+                               float *vx, float *vy, float *vz) const
+{
+  // the offsets are converted to grid units around the shifted origin
+  float scaleX = 1. / m_spacing.x;
+  float scaleY = 1. / m_spacing.y;
+  float scaleZ = 1. / m_spacing.z;
+  float shiftX = (origin.x - m_origin.x) / m_spacing.x;
+  float shiftY = (origin.y - m_origin.y) / m_spacing.y;
+  float shiftZ = (origin.z - m_origin.z) / m_spacing.z;
+  const float *bricks = m_bricks;
+  uint32_t i = 0;
+#if defined (__AVX2__) || defined (__SSE2__)
+  // the cells of g_locateWidth positions at once, then their velocities
+  for (; i + g_locateWidth <= n; i += g_locateWidth)
+    {
+      int32_t cells[3][g_locateWidth];
+      float weights[3][g_locateWidth];
+      LocateSimd (x + i, scaleX, shiftX, m_nx, cells[0], weights[0]);
+      LocateSimd (y + i, scaleY, shiftY, m_ny, cells[1], weights[1]);
+      LocateSimd (z + i, scaleZ, shiftZ, m_nz, cells[2], weights[2]);
+      for (uint32_t l = 0; l < g_locateWidth; l++)
+        {
+          float cellWeights[3] = { weights[0][l], weights[1][l], weights[2][l] };
+          uint64_t corner = m_cellOffsetsX[cells[0][l]] + m_cellOffsetsY[cells[1][l]] + m_cellOffsetsZ[cells[2][l]];
+          float velocity[g_pointFloats];
+          Trilinear (bricks + corner, cellWeights, velocity);
+          vx[i + l] = velocity[0];
+          vy[i + l] = velocity[1];
+          vz[i + l] = velocity[2];
+        }
+    }
+#endif
+  for (; i < n; i++)
+    {
+      float weights[3];
+      uint64_t corner = FindCell (shiftX + x[i] * scaleX, shiftY + y[i] * scaleY, shiftZ + z[i] * scaleZ, weights);
+      float velocity[g_pointFloats];
+      Trilinear (bricks + corner, weights, velocity);
+      vx[i] = velocity[0];
+      vy[i] = velocity[1];
+      vz[i] = velocity[2];
+    }
+}
+
+} // namespace ns3
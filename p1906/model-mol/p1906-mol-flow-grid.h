@@ -0,0 +1,188 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+#ifndef P1906_MOL_FLOW_GRID
+#define P1906_MOL_FLOW_GRID
+
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/vector.h"
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * \ingroup P1906 framework
+ *
+ * \class P1906MOLFlowGrid
+ *
+ * \brief Read-only velocity field [m/s] of the medium (e.g., a blood flow
+ * or a microfluidic profile), sampled on a regular 3D grid and shared by
+ * the Field components of the MOLECULAR example.
+ *
+ * The velocity at a position is trilinearly interpolated between the 8
+ * grid points of its cell. Beyond the grid, the position is clamped to
+ * it, i.e., the flow keeps the velocity of the nearest boundary.
+ *
+ * The grid points are stored in bricks of 8 x 8 x 8 points, each point as
+ * 4 floats (the 3 components and a padding one), so that the 8 corners of
+ * a cell lie in a single brick of 8 KB and a corner is one SIMD load. Two
+ * neighbouring bricks share a face of points, i.e., a brick covers 7 x 7 x
+ * 7 cells and the grid takes about 24 bytes per point. The interpolation
+ * uses AVX2 when the module is compiled with it enabled, SSE2 on any other
+ * x86-64 build, and a scalar loop elsewhere.
+ *
+ * A grid can also be loaded from a binary file (see Write for the
+ * format), which holds the bricks as they are stored in memory and is
+ * mapped read-only: its pages are loaded on demand, as the molecules
+ * reach them, and shared by every process using the same file.
+ */
+
+class P1906MOLFlowGrid : public SimpleRefCount<P1906MOLFlowGrid>
+{
+public:
+  /**
+   * \brief builds a grid holding a copy of the given velocities
+   *
+   * \param origin the position [m] of the first grid point
+   * \param spacing the distance [m] between two grid points along x, y
+   * and z
+   * \param nx the number of grid points along x, at least 2
+   * \param ny the number of grid points along y, at least 2
+   * \param nz the number of grid points along z, at least 2
+   * \param velocities the 3 components [m/s] of each grid point, the
+   * points being ordered by x, then y, then z
+   */
+  static Ptr<const P1906MOLFlowGrid> Create (const Vector &origin, const Vector &spacing,
+                                             uint32_t nx, uint32_t ny, uint32_t nz,
+                                             const float *velocities);
+  /**
+   * \return a grid giving the same velocity [m/s] everywhere
+   */
+  static Ptr<const P1906MOLFlowGrid> CreateUniform (const Vector &velocity);
+
+  /**
+   * \param fileName a grid written by Write
+   * \return the grid mapped from the file, or 0 if it cannot be mapped or
+   * is not a valid grid
+   */
+  static Ptr<const P1906MOLFlowGrid> Load (std::string fileName);
+
+  /**
+   * \brief writes the grid in the binary format read by Load.
+   *
+   * The file starts with a header of fixed size, in the byte order of the
+   * host: the magic "P1906MFG", the format version, the header size, a
+   * byte order mark, the numbers of grid points along x, y and z, the
+   * units of the lengths (m) and of the velocities (m/s), the origin and
+   * the spacing of the grid, then the offset of the bricks and the file
+   * size. The bricks start on a 64-byte boundary and are ordered by x,
+   * then y, then z, like the points within a brick.
+   *
+   * \param fileName the file to create or overwrite
+   * \return whether the file has been written
+   */
+  bool Write (std::string fileName) const;
+
+  ~P1906MOLFlowGrid ();
+
+  Vector GetOrigin (void) const;
+  Vector GetSpacing (void) const;
+  uint32_t GetNx (void) const;
+  uint32_t GetNy (void) const;
+  uint32_t GetNz (void) const;
+
+  /**
+   * \param position the position [m]
+   * \return the interpolated velocity [m/s]
+   */
+  Vector GetVelocity (const Vector &position) const;
+
+  /**
+   * \brief interpolates the velocity of n positions given as single
+   * precision offsets from origin, e.g., the molecules of
+   * P1906MOLParticles
+   *
+   * \param origin the position [m] the offsets are measured from
+   * \param x the offsets [m] along x
+   * \param y the offsets [m] along y
+   * \param z the offsets [m] along z
+   * \param n the number of positions
+   * \param vx filled with the n velocities [m/s] along x
+   * \param vy filled with the n velocities [m/s] along y
+   * \param vz filled with the n velocities [m/s] along z
+   */
+  void Interpolate (const Vector &origin, const float *x, const float *y, const float *z, uint32_t n,
+                    float *vx, float *vy, float *vz) const;
+
+private:
+  /**
+   * \param bricks the bricks, or 0 to allocate them in m_storage
+   */
+  P1906MOLFlowGrid (const Vector &origin, const Vector &spacing,
+                    uint32_t nx, uint32_t ny, uint32_t nz,
+                    const float *bricks);
+
+  P1906MOLFlowGrid (const P1906MOLFlowGrid &);
+  P1906MOLFlowGrid &operator= (const P1906MOLFlowGrid &);
+
+  /**
+   * \brief finds the cell of a position in grid units, clamped to the
+   * grid, and the weights of its upper corners
+   * \return the first corner of the cell within m_bricks
+   */
+  uint64_t FindCell (float u, float v, float w, float *weights) const;
+
+  Vector m_origin;
+  Vector m_spacing;
+  uint32_t m_nx;
+  uint32_t m_ny;
+  uint32_t m_nz;
+  uint32_t m_nBricksX;
+  uint32_t m_nBricksY;
+  uint32_t m_nBricksZ;
+  const float *m_bricks;
+  // the bricks built by Create
+  std::vector<float> m_storage;
+  // the offset within m_bricks of the first corner of each cell along x,
+  // y and z, which add up to the offset of the cell
+  std::vector<uint64_t> m_cellOffsets;
+  const uint64_t *m_cellOffsetsX;
+  const uint64_t *m_cellOffsetsY;
+  const uint64_t *m_cellOffsetsZ;
+
+  // the file mapping m_bricks points to, if any
+  void *m_mapping;
+  uint64_t m_mappingSize;
+};
+
+}
+
+#endif /* P1906_MOL_FLOW_GRID */
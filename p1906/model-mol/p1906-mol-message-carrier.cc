@@ -44,6 +44,9 @@ TypeId P1906MOLMessageCarrier::GetTypeId (void)
 }
 
 P1906MOLMessageCarrier::P1906MOLMessageCarrier ()
+  : m_molecules (0),
+    m_received (false),
+    m_releasedMolecules (0)
 {
   NS_LOG_FUNCTION (this);
   SetMessage (0);
@@ -111,4 +114,48 @@ P1906MOLMessageCarrier::GetMolecules (void)
   return m_molecules;
 }
 
+double
+P1906MOLMessageCarrier::GetReleasedMolecules (void)
+{
+  NS_LOG_FUNCTION (this);
+  return m_received ? m_releasedMolecules : m_molecules;
+}
+
+Ptr<P1906MOLMessageCarrier>
+P1906MOLMessageCarrier::CreateReceivedMessageCarrier (void)
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<P1906MOLMessageCarrier> carrier = CreateObject<P1906MOLMessageCarrier> ();
+  carrier->SetMessage (GetMessage ());
+  carrier->m_duration = m_duration;
+  carrier->m_pulseInterval = m_pulseInterval;
+  carrier->m_startTime = m_startTime;
+  carrier->m_molecules = m_molecules;
+  carrier->m_received = true;
+  carrier->m_releasedMolecules = GetReleasedMolecules ();
+  carrier->m_arrivalBinWidth = m_arrivalBinWidth;
+  carrier->m_arrivals = m_arrivals;
+  return carrier;
+}
+
+void
+P1906MOLMessageCarrier::SetArrivals (Time binWidth, const std::vector<uint32_t> &arrivals)
+{
+  NS_LOG_FUNCTION (this << binWidth << arrivals.size ());
+  m_arrivalBinWidth = binWidth;
+  m_arrivals = arrivals;
+}
+
+const std::vector<uint32_t>&
+P1906MOLMessageCarrier::GetArrivals (void) const
+{
+  return m_arrivals;
+}
+
+Time
+P1906MOLMessageCarrier::GetArrivalBinWidth (void) const
+{
+  return m_arrivalBinWidth;
+}
+
 } // namespace ns3
@@ -35,6 +35,7 @@
 #include "ns3/ptr.h"
 #include "ns3/p1906-message-carrier.h"
 #include <ns3/spectrum-value.h>
+#include <vector>
 
 
 namespace ns3 {
@@ -59,20 +60,48 @@ public:
   virtual ~P1906MOLMessageCarrier ();
 
   void SetDuration (Time t);
-  Time GetDuration (void);
+  virtual Time GetDuration (void);
   void SetPulseInterval (Time t);
   Time GetPulseInterval (void);
   void SetStartTime (Time t);
-  Time GetStartTime (void);
+  virtual Time GetStartTime (void);
 
   void SetMolecules (double q);
   double GetMolecules (void);
+  /**
+   * \returns the molecules released by the transmitter, which differ from
+   * GetMolecules () once the Motion component counted them at a receiver
+   */
+  double GetReleasedMolecules (void);
+
+  /**
+   * \return a carrier seen by a single receiver: it shares the packet and
+   * copies the parameters of this carrier, so that the Motion component can
+   * change its number of molecules without altering the transmitted one
+   */
+  Ptr<P1906MOLMessageCarrier> CreateReceivedMessageCarrier (void);
+
+  /**
+   * \brief sets the molecules counted by a counting receiver of the
+   * particle mode of P1906MOLMotion, per bin of binWidth since the release
+   */
+  void SetArrivals (Time binWidth, const std::vector<uint32_t> &arrivals);
+  /**
+   * \returns the molecules counted per bin since the release, or an empty
+   * histogram if the carrier was not counted
+   */
+  const std::vector<uint32_t>& GetArrivals (void) const;
+  Time GetArrivalBinWidth (void) const;
 
 private:
   Time m_duration;
   Time m_pulseInterval;
   Time m_startTime;
   int m_molecules;
+  bool m_received;
+  int m_releasedMolecules;
+  Time m_arrivalBinWidth;
+  std::vector<uint32_t> m_arrivals;
 };
 
 }
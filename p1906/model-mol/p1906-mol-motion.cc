@@ -36,11 +36,27 @@
 #include "ns3/p1906-net-device.h"
 #include <ns3/spectrum-value.h>
 #include "p1906-mol-message-carrier.h"
+#include "p1906-mol-specificity.h"
+#include "p1906-mol-field.h"
+#include "ns3/p1906-receiver-communication-interface.h"
+#include "ns3/p1906-medium.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("P1906MOLMotion");
 
+namespace {
+
+// m_releaseReceivers of a counting receiver left out of its band
+const uint32_t g_noReceiver = ~0U;
+// the expected counts beyond which Sample draws Gaussian deviates
+const double g_gaussianMin = 1000;
+
+} // namespace
+
 TypeId P1906MOLMotion::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::P1906MOLMotion")
@@ -49,8 +65,21 @@ TypeId P1906MOLMotion::GetTypeId (void)
 }
 
 P1906MOLMotion::P1906MOLMotion ()
+  : m_mode (FICK),
+    m_particleTimeStep (Seconds (0)),
+    m_particleReceiverRadius (0),
+    m_seeded (false),
+    m_particleDelay (0),
+    m_particleCount (0),
+    m_particleBinWidth (0),
+    m_hybridMinMolecules (100),
+    m_hybridMinDistanceRatio (5),
+    m_nParticleLinks (0),
+    m_nAnalyticLinks (0),
+    m_sampler (1)
 {
   NS_LOG_FUNCTION (this);
+  m_seedVariable = CreateObject<UniformRandomVariable> ();
 }
 
 P1906MOLMotion::~P1906MOLMotion ()
@@ -77,6 +106,13 @@ P1906MOLMotion::ComputePropagationDelay (Ptr<P1906CommunicationInterface> src,
 
   NS_LOG_FUNCTION (this << "Fick's low");
 
+  Ptr<P1906MOLField> flow = GetFlow (field);
+  if (m_mode != FICK)
+    {
+      SimulateLink (src, dst, message, flow);
+      return m_particleDelay;
+    }
+
   Ptr<MobilityModel> srcMobility = src->GetP1906NetDevice ()->GetNode ()->GetObject<MobilityModel> ();
   Ptr<MobilityModel> dstMobility = dst->GetP1906NetDevice ()->GetNode ()->GetObject<MobilityModel> ();
 
@@ -84,6 +120,10 @@ P1906MOLMotion::ComputePropagationDelay (Ptr<P1906CommunicationInterface> src,
   double distance = dstMobility->GetDistanceFrom (srcMobility);
   double delay = pow(distance,2)/(GetDiffusionConefficient ()*6);
   double diffusion = GetDiffusionConefficient ();
+  if (flow)
+    {
+      delay = GetDelay (distance, GetMeanVelocity (flow, srcMobility->GetPosition (), dstMobility->GetPosition ()));
+    }
 
   NS_LOG_FUNCTION (this << "[dist,diffusion,delay]" << distance <<  diffusion << delay);
  
@@ -98,8 +138,397 @@ P1906MOLMotion::CalculateReceivedMessageCarrier(Ptr<P1906CommunicationInterface>
 		                                       Ptr<P1906Field> field)
 {
 
-  NS_LOG_FUNCTION (this << "Do nothing for the Fick's low");
-  return message;
+  if (m_mode == FICK)
+    {
+      NS_LOG_FUNCTION (this << "Do nothing for the Fick's low");
+      return message;
+    }
+
+  if (src != m_particleSrc || dst != m_particleDst || message != m_particleMessage)
+    {
+      SimulateLink (src, dst, message, GetFlow (field));
+    }
+  m_particleSrc = 0;
+  m_particleDst = 0;
+  m_particleMessage = 0;
+
+  Ptr<P1906MOLMessageCarrier> received = message->GetObject<P1906MOLMessageCarrier> ()->CreateReceivedMessageCarrier ();
+  received->SetMolecules (m_particleCount);
+  if (GetCountingReceiver (dst))
+    {
+      received->SetArrivals (Seconds (m_particleBinWidth), m_particleArrivals);
+    }
+  NS_LOG_FUNCTION (this << "[molecules]" << m_particleCount);
+  return received;
+}
+
+void
+P1906MOLMotion::Seed (void)
+{
+  if (m_seeded)
+    {
+      return;
+    }
+  uint64_t high = m_seedVariable->GetInteger (0, 0xffffffff);
+  uint64_t low = m_seedVariable->GetInteger (0, 0xffffffff);
+  NS_LOG_FUNCTION (this << ((high << 32) | low));
+  m_particles.SetSeed ((high << 32) | low);
+  m_sampler.seed ((high << 32) | low);
+  m_seeded = true;
+}
+
+Ptr<P1906MOLSpecificity>
+P1906MOLMotion::GetCountingReceiver (Ptr<P1906CommunicationInterface> dst)
+{
+  Ptr<P1906ReceiverCommunicationInterface> rx = dst->GetP1906ReceiverCommunicationInterface ();
+  if (!rx || !rx->GetP1906Specificity ())
+    {
+      return 0;
+    }
+  Ptr<P1906MOLSpecificity> receiver = rx->GetP1906Specificity ()->GetObject<P1906MOLSpecificity> ();
+  if (!receiver || !receiver->IsCountingReceiver ())
+    {
+      return 0;
+    }
+  return receiver;
+}
+
+double
+P1906MOLMotion::GetReceiverRadius (Ptr<P1906MOLSpecificity> receiver, double distance) const
+{
+  if (receiver)
+    {
+      return receiver->GetReceiverRadius ();
+    }
+  return (m_particleReceiverRadius > 0) ? m_particleReceiverRadius : distance / 10;
+}
+
+Ptr<P1906MOLField>
+P1906MOLMotion::GetFlow (Ptr<P1906Field> field) const
+{
+  if (!field || field->IsEmpty ())
+    {
+      return 0;
+    }
+  return field->GetObject<P1906MOLField> ();
+}
+
+Vector
+P1906MOLMotion::GetMeanVelocity (Ptr<P1906MOLField> flow, const Vector &from, const Vector &to) const
+{
+  if (!flow)
+    {
+      return Vector (0, 0, 0);
+    }
+  return flow->GetMeanVelocity (from, to);
+}
+
+double
+P1906MOLMotion::GetDelay (double distance, const Vector &velocity) const
+{
+  return P1906MOLField::GetPeakTime (m_diffusionCoefficient, distance, velocity);
+}
+
+double
+P1906MOLMotion::GetConcentration (const Vector &displacement, const Vector &velocity, double t) const
+{
+  return P1906MOLField::GetConcentration (m_diffusionCoefficient, displacement, velocity, t);
+}
+
+void
+P1906MOLMotion::SimulateLink (Ptr<P1906CommunicationInterface> src,
+                              Ptr<P1906CommunicationInterface> dst,
+                              Ptr<P1906MessageCarrier> message,
+                              Ptr<P1906MOLField> flow)
+{
+  NS_LOG_FUNCTION (this);
+  Seed ();
+  Ptr<P1906MOLSpecificity> receiver = GetCountingReceiver (dst);
+  Vector srcPosition = src->GetP1906NetDevice ()->GetNode ()->GetObject<MobilityModel> ()->GetPosition ();
+  Vector dstPosition = dst->GetP1906NetDevice ()->GetNode ()->GetObject<MobilityModel> ()->GetPosition ();
+  Vector velocity = GetMeanVelocity (flow, srcPosition, dstPosition);
+  if (m_mode == HYBRID)
+    {
+      Vector displacement (dstPosition.x - srcPosition.x, dstPosition.y - srcPosition.y, dstPosition.z - srcPosition.z);
+      double distance = CalculateDistance (srcPosition, dstPosition);
+      double molecules = message->GetObject<P1906MOLMessageCarrier> ()->GetMolecules ();
+      double radius = GetReceiverRadius (receiver, distance);
+      bool absorbing = receiver && receiver->IsAbsorbing ();
+      if (!UseParticles (molecules, displacement, velocity, radius, absorbing))
+        {
+          m_nAnalyticLinks++;
+          SampleLink (message, displacement, velocity, radius, absorbing);
+          m_particleSrc = src;
+          m_particleDst = dst;
+          m_particleMessage = message;
+          return;
+        }
+    }
+  m_nParticleLinks++;
+
+  if (src != m_releaseSrc || message != m_releaseMessage || m_countingIndex.find (dst) == m_countingIndex.end ())
+    {
+      AddCountingReceivers (dst->GetP1906Medium ());
+      AddCountingReceiver (dst);
+    }
+  if (src != m_releaseSrc || message != m_releaseMessage)
+    {
+      // a new release, none of whose bands is simulated yet
+      m_releaseSrc = src;
+      m_releaseMessage = message;
+      m_releaseBands.clear ();
+      m_releaseReceivers.assign (m_countingInterfaces.size (), g_noReceiver);
+    }
+
+  double distance = CalculateDistance (srcPosition, dstPosition);
+  double delay = GetDelay (distance, velocity);
+  int band = GetReleaseBand (delay);
+  if (m_releaseBands.find (band) == m_releaseBands.end ())
+    {
+      SimulateRelease (src, message, flow, band);
+    }
+  const ReleaseBand &release = m_releaseBands[band];
+  double dt = release.m_timeStep;
+
+  // the arrivals within twice the closed-form delay, as SampleLink samples
+  uint32_t nSteps = (dt > 0) ? static_cast<uint32_t> (ceil (2 * delay / dt)) : 0;
+  uint32_t index = m_releaseReceivers[m_countingIndex[dst]];
+  m_particleArrivals.clear ();
+  if (index != g_noReceiver)
+    {
+      const std::vector<uint32_t> &histogram = release.m_receivers.GetHistogram (index);
+      m_particleArrivals.assign (histogram.begin (), histogram.begin () + std::min<size_t> (histogram.size (), nSteps + 1));
+    }
+  uint32_t peakBin = 0;
+  uint32_t peak = 0;
+  uint32_t total = 0;
+  for (uint32_t bin = 0; bin < m_particleArrivals.size (); bin++)
+    {
+      total += m_particleArrivals[bin];
+      if (m_particleArrivals[bin] > peak)
+        {
+          peakBin = bin;
+          peak = m_particleArrivals[bin];
+        }
+    }
+
+  m_particleSrc = src;
+  m_particleDst = dst;
+  m_particleMessage = message;
+  m_particleCount = (receiver && receiver->IsAbsorbing ()) ? total : peak;
+  m_particleBinWidth = dt;
+  // no molecule reached the receiver: the closed-form delay is kept
+  m_particleDelay = (peak > 0) ? peakBin * dt : delay;
+
+  NS_LOG_FUNCTION (this << "[dist,delay,molecules]" << distance << m_particleDelay << m_particleCount);
+}
+
+int
+P1906MOLMotion::GetReleaseBand (double delay) const
+{
+  if (delay <= 0)
+    {
+      return std::numeric_limits<int>::min ();
+    }
+  return static_cast<int> (floor (log2 (delay)));
+}
+
+void
+P1906MOLMotion::SimulateRelease (Ptr<P1906CommunicationInterface> src,
+                                 Ptr<P1906MessageCarrier> message,
+                                 Ptr<P1906MOLField> flow,
+                                 int band)
+{
+  NS_LOG_FUNCTION (this << band << m_countingInterfaces.size ());
+  Vector origin = src->GetP1906NetDevice ()->GetNode ()->GetObject<MobilityModel> ()->GetPosition ();
+  Ptr<P1906MOLMessageCarrier> m = message->GetObject<P1906MOLMessageCarrier> ();
+
+  // a hundredth of the shortest delay of the band, whatever the receivers
+  double dt = m_particleTimeStep.GetSeconds ();
+  if (dt <= 0)
+    {
+      dt = ldexp (1., band) / 100;
+    }
+  ReleaseBand &release = m_releaseBands[band];
+  release.m_receivers.Clear ();
+  release.m_timeStep = dt;
+
+  // the transmitter does not count its own release, nor do the receivers
+  // the hybrid mode samples; the receivers that are not counting ones are
+  // passive spheres of the particle receiver radius
+  double maxDelay = 0;
+  for (uint32_t i = 0; i < m_countingInterfaces.size (); i++)
+    {
+      Ptr<P1906CommunicationInterface> dst = m_countingInterfaces[i];
+      if (dst == src)
+        {
+          continue;
+        }
+      Ptr<P1906MOLSpecificity> receiver = GetCountingReceiver (dst);
+      Vector position = dst->GetP1906NetDevice ()->GetNode ()->GetObject<MobilityModel> ()->GetPosition ();
+      Vector displacement (position.x - origin.x, position.y - origin.y, position.z - origin.z);
+      Vector velocity = GetMeanVelocity (flow, origin, position);
+      double distance = CalculateDistance (origin, position);
+      double delay = GetDelay (distance, velocity);
+      if (GetReleaseBand (delay) != band)
+        {
+          continue;
+        }
+      double radius = GetReceiverRadius (receiver, distance);
+      bool absorbing = receiver && receiver->IsAbsorbing ();
+      if (m_mode == HYBRID && !UseParticles (m->GetMolecules (), displacement, velocity, radius, absorbing))
+        {
+          continue;
+        }
+      m_releaseReceivers[i] = release.m_receivers.Add (position, radius, absorbing);
+      maxDelay = std::max (maxDelay, delay);
+    }
+  uint32_t nSteps = (dt > 0) ? static_cast<uint32_t> (ceil (2 * maxDelay / dt)) : 0;
+
+  if (release.m_receivers.GetN () == 0)
+    {
+      NS_LOG_FUNCTION (this << "no receiver to count --> no molecule released");
+      return;
+    }
+
+  const P1906MOLFlowGrid *grid = flow ? PeekPointer (flow->GetFlowGrid ()) : 0;
+  m_particles.Release (static_cast<uint32_t> (m->GetMolecules ()), origin);
+  for (uint32_t step = 1; step <= nSteps && m_particles.GetN () > 0; step++)
+    {
+      m_particles.Step (m_diffusionCoefficient, dt, grid);
+      release.m_receivers.Observe (m_particles, step);
+    }
+
+  NS_LOG_FUNCTION (this << "[receivers,steps,dt,remaining]" << release.m_receivers.GetN () << nSteps << dt << m_particles.GetN ());
+}
+
+bool
+P1906MOLMotion::UseParticles (double molecules, const Vector &displacement, const Vector &velocity,
+                              double radius, bool absorbing) const
+{
+  double distance = CalculateDistance (displacement, Vector (0, 0, 0));
+  if (distance < m_hybridMinDistanceRatio * radius)
+    {
+      return true;
+    }
+  if (absorbing && (velocity.x != 0 || velocity.y != 0 || velocity.z != 0))
+    {
+      return true;
+    }
+  return GetExpectedMolecules (molecules, displacement, velocity, radius, absorbing) < m_hybridMinMolecules;
+}
+
+double
+P1906MOLMotion::GetExpectedMolecules (double molecules, const Vector &displacement, const Vector &velocity,
+                                      double radius, bool absorbing) const
+{
+  double distance = CalculateDistance (displacement, Vector (0, 0, 0));
+  if (absorbing)
+    {
+      // the probability that a molecule hits the sphere within the window
+      // of SampleLink, twice the delay
+      double gap = std::max (0., distance - radius);
+      double t = 2 * GetDelay (distance, velocity);
+      return molecules * std::min (1., radius / distance) * erfc (gap / sqrt (4 * m_diffusionCoefficient * t));
+    }
+  // the concentration at the peak time, d^2 / (6 D) in a still medium,
+  // times the volume
+  double volume = 4. / 3. * M_PI * pow(radius,3);
+  return molecules * volume * GetConcentration (displacement, velocity, GetDelay (distance, velocity));
+}
+
+uint32_t
+P1906MOLMotion::Sample (double expected)
+{
+  if (expected <= 0)
+    {
+      return 0;
+    }
+  if (expected < g_gaussianMin)
+    {
+      std::poisson_distribution<uint32_t> poisson (expected);
+      return poisson (m_sampler);
+    }
+  std::normal_distribution<double> normal (expected, sqrt (expected));
+  return static_cast<uint32_t> (std::max (0., floor (normal (m_sampler) + 0.5)));
+}
+
+void
+P1906MOLMotion::SampleLink (Ptr<P1906MessageCarrier> message, const Vector &displacement, const Vector &velocity,
+                            double radius, bool absorbing)
+{
+  double distance = CalculateDistance (displacement, Vector (0, 0, 0));
+  NS_LOG_FUNCTION (this << distance << radius << absorbing);
+  double molecules = message->GetObject<P1906MOLMessageCarrier> ()->GetMolecules ();
+  double analyticDelay = GetDelay (distance, velocity);
+  double dt = m_particleTimeStep.GetSeconds ();
+  if (dt <= 0)
+    {
+      dt = analyticDelay / 100;
+    }
+  uint32_t nSteps = static_cast<uint32_t> (ceil (2 * analyticDelay / dt));
+
+  /*
+   * the bins of the particle mode: the molecules within a passive sphere at
+   * the end of the bin, for a uniform concentration over the sphere, or
+   * those an absorbing sphere captured during the bin, whose first-passage
+   * probability by time t is R / d * erfc ((d - R) / sqrt (4 D t)) in a
+   * still medium
+   */
+  double gap = std::max (0., distance - radius);
+  double hit = std::min (1., radius / distance);
+  double volume = 4. / 3. * M_PI * pow(radius,3);
+  double captured = 0;
+  m_particleArrivals.assign (nSteps + 1, 0);
+  for (uint32_t step = 1; step <= nSteps; step++)
+    {
+      double t = step * dt;
+      double expected;
+      if (absorbing)
+        {
+          double total = hit * erfc (gap / sqrt (4 * m_diffusionCoefficient * t));
+          expected = molecules * (total - captured);
+          captured = total;
+        }
+      else
+        {
+          expected = molecules * volume * GetConcentration (displacement, velocity, t);
+        }
+      m_particleArrivals[step] = Sample (expected);
+    }
+
+  uint32_t peakBin = 0;
+  uint32_t peak = 0;
+  uint32_t total = 0;
+  for (uint32_t bin = 0; bin <= nSteps; bin++)
+    {
+      total += m_particleArrivals[bin];
+      if (m_particleArrivals[bin] > peak)
+        {
+          peakBin = bin;
+          peak = m_particleArrivals[bin];
+        }
+    }
+  m_particleCount = absorbing ? total : peak;
+  m_particleBinWidth = dt;
+  m_particleDelay = (peak > 0) ? peakBin * dt : analyticDelay;
+
+  NS_LOG_FUNCTION (this << "[steps,dt,delay,molecules]" << nSteps << dt << m_particleDelay << m_particleCount);
+}
+
+bool
+P1906MOLMotion::IsThreadSafe (void) const
+{
+  NS_LOG_FUNCTION (this);
+  // the particle mode runs its own threads over the molecules of a link, and
+  // a subclass overriding the message carrier methods must opt in again
+  return GetInstanceTypeId () == P1906MOLMotion::GetTypeId () && m_mode == FICK;
+}
+
+void
+P1906MOLMotion::PropagateLink (Link &link) const
+{
+  link.m_delay = pow(link.m_distance,2)/(m_diffusionCoefficient*6);
 }
 
 void
@@ -116,5 +545,136 @@ P1906MOLMotion::GetDiffusionConefficient (void)
   return m_diffusionCoefficient;
 }
 
+void
+P1906MOLMotion::SetMode (Mode mode)
+{
+  NS_LOG_FUNCTION (this << mode);
+  m_mode = mode;
+}
+
+P1906MOLMotion::Mode
+P1906MOLMotion::GetMode (void) const
+{
+  return m_mode;
+}
+
+void
+P1906MOLMotion::SetHybridThresholds (double minMolecules, double minDistanceRatio)
+{
+  NS_LOG_FUNCTION (this << minMolecules << minDistanceRatio);
+  m_hybridMinMolecules = minMolecules;
+  m_hybridMinDistanceRatio = minDistanceRatio;
+}
+
+double
+P1906MOLMotion::GetHybridMinMolecules (void) const
+{
+  return m_hybridMinMolecules;
+}
+
+double
+P1906MOLMotion::GetHybridMinDistanceRatio (void) const
+{
+  return m_hybridMinDistanceRatio;
+}
+
+uint64_t
+P1906MOLMotion::GetNParticleLinks (void) const
+{
+  return m_nParticleLinks;
+}
+
+uint64_t
+P1906MOLMotion::GetNAnalyticLinks (void) const
+{
+  return m_nAnalyticLinks;
+}
+
+void
+P1906MOLMotion::SetParticleTimeStep (Time dt)
+{
+  NS_LOG_FUNCTION (this << dt);
+  m_particleTimeStep = dt;
+}
+
+Time
+P1906MOLMotion::GetParticleTimeStep (void) const
+{
+  return m_particleTimeStep;
+}
+
+void
+P1906MOLMotion::SetParticleReceiverRadius (double radius)
+{
+  NS_LOG_FUNCTION (this << radius);
+  m_particleReceiverRadius = radius;
+}
+
+double
+P1906MOLMotion::GetParticleReceiverRadius (void) const
+{
+  return m_particleReceiverRadius;
+}
+
+void
+P1906MOLMotion::SetParticleSeed (uint64_t seed)
+{
+  NS_LOG_FUNCTION (this << seed);
+  m_particles.SetSeed (seed);
+  m_sampler.seed (seed);
+  m_seeded = true;
+}
+
+int64_t
+P1906MOLMotion::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_seedVariable->SetStream (stream);
+  return 1;
+}
+
+void
+P1906MOLMotion::SetNThreads (uint32_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+  m_particles.SetNThreads (n);
+}
+
+void
+P1906MOLMotion::AddCountingReceiver (Ptr<P1906CommunicationInterface> dst)
+{
+  NS_LOG_FUNCTION (this << dst);
+  if (m_countingIndex.find (dst) != m_countingIndex.end ())
+    {
+      return;
+    }
+  m_countingIndex[dst] = m_countingInterfaces.size ();
+  m_countingInterfaces.push_back (dst);
+  // the last release did not count this receiver
+  m_releaseMessage = 0;
+}
+
+void
+P1906MOLMotion::AddCountingReceivers (Ptr<P1906Medium> medium)
+{
+  NS_LOG_FUNCTION (this << medium);
+  if (!medium || !medium->GetP1906CommunicationInterfaces ())
+    {
+      return;
+    }
+  // the receivers the medium can not locate are never propagated to
+  P1906Medium::P1906CommunicationInterfaces *interfaces = medium->GetP1906CommunicationInterfaces ();
+  for (uint32_t i = 0; i < interfaces->size (); i++)
+    {
+      Ptr<P1906CommunicationInterface> dst = (*interfaces)[i];
+      if (dst->GetP1906ReceiverCommunicationInterface () && dst->GetP1906NetDevice () &&
+          dst->GetP1906NetDevice ()->GetNode () &&
+          dst->GetP1906NetDevice ()->GetNode ()->GetObject<MobilityModel> ())
+        {
+          AddCountingReceiver (dst);
+        }
+    }
+}
+
 
 } // namespace ns3
@@ -34,9 +34,19 @@
 #include "ns3/nstime.h"
 #include "ns3/ptr.h"
 #include "ns3/p1906-motion.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/p1906-mol-particles.h"
+#include "ns3/p1906-mol-counting-receivers.h"
+#include <map>
+#include <vector>
+#include <random>
 
 namespace ns3 {
 
+class P1906MOLSpecificity;
+class P1906MOLField;
+class P1906Medium;
+
 /**
  * \ingroup P1906 framework
  *
@@ -44,6 +54,44 @@ namespace ns3 {
  *
  * \brief Base class implementing the Motion component of
  * the P1906 framework, dedicated to the MOLECULAR Example
+ *
+ * By default the propagation delay is the closed-form d^2 / (6 D) of
+ * Fick's law and the message carrier is received unchanged. The particle
+ * mode instead releases the molecules of the carrier at the transmitter,
+ * follows their Brownian motion with P1906MOLParticles, and counts them at
+ * each time step in a sphere around each receiver.
+ *
+ * The receivers are counted together: the receivers whose closed-form
+ * delays lie within the same power of two share a release of the message
+ * carrier, followed for twice the longest of these delays and counted with
+ * P1906MOLCountingReceivers at their positions of the release, so that a
+ * release costs one pass over the molecules per time step whatever the
+ * number of receivers. Each receiver keeps the arrivals within twice its
+ * own delay, the window of the hybrid mode. A receiver whose
+ * P1906MOLSpecificity is a counting receiver uses its own sphere, passive
+ * or absorbing; any other one is a passive sphere of the particle receiver
+ * radius. The delay of a receiver is the time of its largest arrival bin,
+ * and the received message carrier holds its arrivals and their total
+ * (absorbing receiver) or largest bin (passive receiver) as its number of
+ * molecules. The molecules an absorbing receiver counts are no longer seen
+ * by the other receivers of its release.
+ *
+ * The hybrid mode chooses between the two for each pair of a release and
+ * a receiver. A receiver expecting few molecules, or too close to the
+ * transmitter for the point approximation of Fick's law, takes the
+ * particle mode; any other one samples its arrivals from the closed-form
+ * expected counts, with Poisson deviates, or Gaussian ones beyond 1000
+ * molecules: the concentration of Fick's law times the volume of a
+ * passive sphere, or the first-passage probability to an absorbing one.
+ *
+ * When the P1906MOLField of the transmitter holds a flow, the molecules
+ * also drift with the medium. The particle modes move them with the
+ * velocity of the flow at their positions, and the closed-form delay
+ * becomes the peak time of the advection-diffusion impulse response,
+ * d^2 / (3 D + sqrt (9 D^2 + v^2 d^2)), for the velocity v of the flow
+ * averaged along the link. The hybrid mode samples the passive receivers
+ * from that response too, and simulates the absorbing ones, whose
+ * first-passage probability has no closed form with a drift.
  */
 
 class P1906MOLMotion : public P1906Motion
@@ -64,11 +112,188 @@ public:
   		                                                           Ptr<P1906MessageCarrier> message,
   		                                                           Ptr<P1906Field> field);
 
+  /**
+   * \returns true for a P1906MOLMotion in the FICK mode, false otherwise
+   * and for its subclasses that do not override it
+   */
+  virtual bool IsThreadSafe (void) const;
+  virtual void PropagateLink (Link &link) const;
+
   void SetDiffusionCoefficient (double d);
   double GetDiffusionConefficient (void);
 
+  /**
+   * \brief the propagation models of the Motion
+   */
+  enum Mode
+  {
+    FICK,     //!< closed-form delay, carrier received unchanged (the default)
+    PARTICLE, //!< Brownian motion of every molecule
+    HYBRID    //!< PARTICLE or sampled expected counts, link by link
+  };
+
+  void SetMode (Mode mode);
+  Mode GetMode (void) const;
+  /**
+   * \param minMolecules the molecules a receiver must expect, at the peak
+   * of the concentration (passive) or within twice the delay (absorbing),
+   * for the hybrid mode to sample it instead of simulating the particles;
+   * 100 by default
+   * \param minDistanceRatio the smallest ratio of the distance to the radius
+   * of the receiver sampled by the hybrid mode; 5 by default
+   */
+  void SetHybridThresholds (double minMolecules, double minDistanceRatio);
+  double GetHybridMinMolecules (void) const;
+  double GetHybridMinDistanceRatio (void) const;
+  /**
+   * \returns the number of links whose arrivals were simulated with
+   * particles, respectively sampled from the closed-form expected counts,
+   * since the creation of the Motion
+   */
+  uint64_t GetNParticleLinks (void) const;
+  uint64_t GetNAnalyticLinks (void) const;
+  /**
+   * \param dt the time step of the particle mode, or 0 (the default) for a
+   * hundredth of the power of two below the closed-form delay of each
+   * receiver, which sets the release it shares with other receivers. The
+   * molecules are tested at the end of each step, so that an absorbing
+   * receiver needs sqrt (2 D dt) well below its radius not to miss
+   * crossings.
+   */
+  void SetParticleTimeStep (Time dt);
+  Time GetParticleTimeStep (void) const;
+  /**
+   * \param radius the radius [m] of the sphere counting the molecules
+   * around the receivers that are not counting receivers, or 0 (the
+   * default) for a tenth of the distance of each link
+   */
+  void SetParticleReceiverRadius (double radius);
+  double GetParticleReceiverRadius (void) const;
+  /**
+   * \brief sets the seed of the displacements of the molecules and of the
+   * samples of the hybrid mode. Without it, the seed is drawn from the
+   * stream of the Motion on the first link simulated, i.e., from the seed
+   * and the run of RngSeedManager.
+   */
+  void SetParticleSeed (uint64_t seed);
+  /**
+   * \brief assigns a fixed stream to the random variable drawing the seed
+   * of the particle and hybrid modes
+   * \param stream the first stream index to use
+   * \returns the number of stream indices used, i.e., 1
+   */
+  int64_t AssignStreams (int64_t stream);
+  /**
+   * \param n the number of threads advancing the molecules, see
+   * P1906MOLParticles::SetNThreads
+   */
+  void SetNThreads (uint32_t n);
+
+  /**
+   * \brief registers a receiver, so that the releases count it: with its
+   * own sphere if its P1906MOLSpecificity is a counting receiver, with a
+   * passive sphere of the particle receiver radius otherwise. The
+   * receivers of the medium of a link are registered automatically before
+   * each release, so that its links are counted from the same simulation
+   * whatever order they are propagated in; registering another receiver
+   * during a release has it simulated again.
+   */
+  void AddCountingReceiver (Ptr<P1906CommunicationInterface> dst);
+
 private:
+  /**
+   * \brief draws the seed of the particle modes, unless already set
+   */
+  void Seed (void);
+  Ptr<P1906MOLSpecificity> GetCountingReceiver (Ptr<P1906CommunicationInterface> dst);
+  /**
+   * \brief registers the located receivers of medium, if any
+   */
+  void AddCountingReceivers (Ptr<P1906Medium> medium);
+  /**
+   * \returns the radius [m] of the sphere of the counting receiver, or
+   * the particle receiver radius for any other receiver at distance
+   */
+  double GetReceiverRadius (Ptr<P1906MOLSpecificity> receiver, double distance) const;
+  /**
+   * \returns the field if it holds a flow, 0 otherwise
+   */
+  Ptr<P1906MOLField> GetFlow (Ptr<P1906Field> field) const;
+  Vector GetMeanVelocity (Ptr<P1906MOLField> flow, const Vector &from, const Vector &to) const;
+  /**
+   * \returns the peak time [s] of the concentration at distance from a
+   * release drifting at velocity (see P1906MOLField::GetPeakTime)
+   */
+  double GetDelay (double distance, const Vector &velocity) const;
+  /**
+   * \returns the concentration [1/m^3] at displacement from a release of
+   * one molecule drifting at velocity, t seconds after the release (see
+   * P1906MOLField::GetConcentration)
+   */
+  double GetConcentration (const Vector &displacement, const Vector &velocity, double t) const;
+  void SimulateLink (Ptr<P1906CommunicationInterface> src,
+                     Ptr<P1906CommunicationInterface> dst,
+                     Ptr<P1906MessageCarrier> message,
+                     Ptr<P1906MOLField> flow);
+  /**
+   * \returns the band of the receivers sharing a release, the exponent of
+   * the power of two below their closed-form delay [s]
+   */
+  int GetReleaseBand (double delay) const;
+  /**
+   * \brief releases the molecules of message at src and counts them at the
+   * registered receivers of band
+   */
+  void SimulateRelease (Ptr<P1906CommunicationInterface> src,
+                        Ptr<P1906MessageCarrier> message,
+                        Ptr<P1906MOLField> flow,
+                        int band);
+  bool UseParticles (double molecules, const Vector &displacement, const Vector &velocity,
+                     double radius, bool absorbing) const;
+  double GetExpectedMolecules (double molecules, const Vector &displacement, const Vector &velocity,
+                               double radius, bool absorbing) const;
+  uint32_t Sample (double expected);
+  void SampleLink (Ptr<P1906MessageCarrier> message, const Vector &displacement, const Vector &velocity,
+                   double radius, bool absorbing);
+
   double m_diffusionCoefficient;
+
+  Mode m_mode;
+  Time m_particleTimeStep;
+  double m_particleReceiverRadius;
+  P1906MOLParticles m_particles;
+  Ptr<UniformRandomVariable> m_seedVariable;
+  bool m_seeded;
+  // the last link simulated by ComputePropagationDelay, whose received
+  // message carrier CalculateReceivedMessageCarrier then creates
+  Ptr<P1906CommunicationInterface> m_particleSrc;
+  Ptr<P1906CommunicationInterface> m_particleDst;
+  Ptr<P1906MessageCarrier> m_particleMessage;
+  double m_particleDelay;
+  uint32_t m_particleCount;
+  std::vector<uint32_t> m_particleArrivals;
+  double m_particleBinWidth;
+
+  double m_hybridMinMolecules;
+  double m_hybridMinDistanceRatio;
+  uint64_t m_nParticleLinks;
+  uint64_t m_nAnalyticLinks;
+  std::mt19937_64 m_sampler;
+
+  // the receivers of the particle mode, the last release counted by them
+  // and the bands of that release simulated so far, with the index of each
+  // receiver in its band
+  struct ReleaseBand
+  {
+    P1906MOLCountingReceivers m_receivers;
+    double m_timeStep;
+  };
+  std::vector<Ptr<P1906CommunicationInterface> > m_countingInterfaces;
+  std::map<Ptr<P1906CommunicationInterface>, uint32_t> m_countingIndex;
+  std::vector<uint32_t> m_releaseReceivers;
+  Ptr<P1906CommunicationInterface> m_releaseSrc;
+  Ptr<P1906MessageCarrier> m_releaseMessage;
+  std::map<int, ReleaseBand> m_releaseBands;
 };
 
 }
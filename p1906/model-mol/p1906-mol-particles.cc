@@ -0,0 +1,568 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+#include "ns3/log.h"
+
+#include "p1906-mol-particles.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#if defined (__AVX2__)
+#include <immintrin.h>
+#elif defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("P1906MOLParticles");
+
+namespace {
+
+/*
+ * Each block of molecules draws 3 * g_blockSize normal deviates, i.e.,
+ * g_nPairs Box-Muller pairs, into a buffer on the stack of its thread.
+ */
+const uint32_t g_blockSize = 2048;
+const uint32_t g_nPairs = 3 * g_blockSize / 2;
+
+/*
+ * A deviate pair p of a block hashes 2p and 2p + 1 with the two keys of the
+ * block. The first hash gives u in (0, 1) and the radius sqrt (-2 ln (u)),
+ * the second one an angle b in (-pi/4, pi/4) from its upper 24 bits and a
+ * quadrant from its 2 lower bits, so that the angle b + q pi/2 is uniform.
+ */
+const float g_uniformScale = 1.f / 16777216.f;
+const float g_halfPi = 1.57079632679489662f;
+const float g_ln2 = 0.693147180559945309f;
+const float g_sqrt2 = 1.41421356237309505f;
+const uint32_t g_hashMultiplier0 = 0x7feb352dU;
+const uint32_t g_hashMultiplier1 = 0x846ca68bU;
+
+/*
+ * ln (u) = e ln 2 + ln (m), with u = 2^e * m and m in [sqrt (1/2),
+ * sqrt (2)), and ln (m) = 2 atanh (s) with s = (m - 1) / (m + 1), whose odd
+ * series is below the float precision with 5 terms. sin and cos are their
+ * Taylor polynomials on [-pi/4, pi/4], in b^2.
+ */
+const float g_logCoefficients[] = {2.f / 9.f, 2.f / 7.f, 2.f / 5.f, 2.f / 3.f, 2.f};
+const float g_sinCoefficients[] = {1.f / 362880.f, -1.f / 5040.f, 1.f / 120.f, -1.f / 6.f, 1.f};
+const float g_cosCoefficients[] = {-1.f / 3628800.f, 1.f / 40320.f, -1.f / 720.f, 1.f / 24.f, -1.f / 2.f, 1.f};
+const uint32_t g_logNCoefficients = sizeof (g_logCoefficients) / sizeof (g_logCoefficients[0]);
+const uint32_t g_sinNCoefficients = sizeof (g_sinCoefficients) / sizeof (g_sinCoefficients[0]);
+const uint32_t g_cosNCoefficients = sizeof (g_cosCoefficients) / sizeof (g_cosCoefficients[0]);
+
+uint64_t
+SplitMix64 (uint64_t x)
+{
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+#if !defined (__SSE2__)
+inline uint32_t
+Hash (uint32_t x)
+{
+  x ^= x >> 16;
+  x *= g_hashMultiplier0;
+  x ^= x >> 15;
+  x *= g_hashMultiplier1;
+  x ^= x >> 16;
+  return x;
+}
+
+inline float
+LogScalar (float u)
+{
+  uint32_t bits;
+  std::memcpy (&bits, &u, sizeof (bits));
+  float e = static_cast<float> (static_cast<int32_t> (bits >> 23) - 127);
+  bits = (bits & 0x007fffffU) | 0x3f800000U;
+  float m;
+  std::memcpy (&m, &bits, sizeof (m));
+  if (m > g_sqrt2)
+    {
+      m *= 0.5f;
+      e += 1.f;
+    }
+  float s = (m - 1.f) / (m + 1.f);
+  float z = s * s;
+  float p = 0.f;
+  for (uint32_t j = 0; j < g_logNCoefficients; j++)
+    {
+      p = p * z + g_logCoefficients[j];
+    }
+  return e * g_ln2 + s * p;
+}
+
+void
+NormalsScalar (uint32_t key0, uint32_t key1, float *normals)
+{
+  for (uint32_t p = 0; p < g_nPairs; p++)
+    {
+      uint32_t h0 = Hash (Hash (2 * p + key0) ^ key1);
+      uint32_t h1 = Hash (Hash (2 * p + 1 + key0) ^ key1);
+      float u = ((h0 >> 8) + 0.5f) * g_uniformScale;
+      float r = std::sqrt (-2.f * LogScalar (u));
+      float b = (((h1 >> 8) + 0.5f) * g_uniformScale - 0.5f) * g_halfPi;
+      float z = b * b;
+      float s = 0.f;
+      float c = 0.f;
+      for (uint32_t j = 0; j < g_sinNCoefficients; j++)
+        {
+          s = s * z + g_sinCoefficients[j];
+        }
+      s *= b;
+      for (uint32_t j = 0; j < g_cosNCoefficients; j++)
+        {
+          c = c * z + g_cosCoefficients[j];
+        }
+      if (h1 & 1)
+        {
+          float t = c;
+          c = -s;
+          s = t;
+        }
+      if (h1 & 2)
+        {
+          c = -c;
+          s = -s;
+        }
+      normals[p] = r * c;
+      normals[p + g_nPairs] = r * s;
+    }
+}
+#endif
+
+#if defined (__AVX2__)
+inline __m256i
+Hash256 (__m256i x)
+{
+  x = _mm256_xor_si256 (x, _mm256_srli_epi32 (x, 16));
+  x = _mm256_mullo_epi32 (x, _mm256_set1_epi32 (static_cast<int32_t> (g_hashMultiplier0)));
+  x = _mm256_xor_si256 (x, _mm256_srli_epi32 (x, 15));
+  x = _mm256_mullo_epi32 (x, _mm256_set1_epi32 (static_cast<int32_t> (g_hashMultiplier1)));
+  return _mm256_xor_si256 (x, _mm256_srli_epi32 (x, 16));
+}
+
+inline __m256
+Uniform256 (__m256i h)
+{
+  __m256 u = _mm256_cvtepi32_ps (_mm256_srli_epi32 (h, 8));
+  return _mm256_mul_ps (_mm256_add_ps (u, _mm256_set1_ps (0.5f)), _mm256_set1_ps (g_uniformScale));
+}
+
+inline __m256
+Log256 (__m256 u)
+{
+  __m256i bits = _mm256_castps_si256 (u);
+  __m256 e = _mm256_cvtepi32_ps (_mm256_sub_epi32 (_mm256_srli_epi32 (bits, 23), _mm256_set1_epi32 (127)));
+  __m256 m = _mm256_castsi256_ps (_mm256_or_si256 (_mm256_and_si256 (bits, _mm256_set1_epi32 (0x007fffff)),
+                                                   _mm256_set1_epi32 (0x3f800000)));
+  __m256 large = _mm256_cmp_ps (m, _mm256_set1_ps (g_sqrt2), _CMP_GT_OQ);
+  m = _mm256_blendv_ps (m, _mm256_mul_ps (m, _mm256_set1_ps (0.5f)), large);
+  e = _mm256_add_ps (e, _mm256_and_ps (large, _mm256_set1_ps (1.f)));
+  __m256 s = _mm256_div_ps (_mm256_sub_ps (m, _mm256_set1_ps (1.f)), _mm256_add_ps (m, _mm256_set1_ps (1.f)));
+  __m256 z = _mm256_mul_ps (s, s);
+  __m256 p = _mm256_setzero_ps ();
+  for (uint32_t j = 0; j < g_logNCoefficients; j++)
+    {
+      p = _mm256_add_ps (_mm256_mul_ps (p, z), _mm256_set1_ps (g_logCoefficients[j]));
+    }
+  return _mm256_add_ps (_mm256_mul_ps (e, _mm256_set1_ps (g_ln2)), _mm256_mul_ps (s, p));
+}
+
+void
+Normals256 (uint32_t key0, uint32_t key1, float *normals)
+{
+  const __m256i lanes = _mm256_setr_epi32 (0, 2, 4, 6, 8, 10, 12, 14);
+  const __m256i k0 = _mm256_set1_epi32 (static_cast<int32_t> (key0));
+  const __m256i k1 = _mm256_set1_epi32 (static_cast<int32_t> (key1));
+  for (uint32_t p = 0; p < g_nPairs; p += 8)
+    {
+      __m256i counter = _mm256_add_epi32 (_mm256_set1_epi32 (static_cast<int32_t> (2 * p)), lanes);
+      __m256i h0 = Hash256 (_mm256_xor_si256 (Hash256 (_mm256_add_epi32 (counter, k0)), k1));
+      counter = _mm256_add_epi32 (counter, _mm256_set1_epi32 (1));
+      __m256i h1 = Hash256 (_mm256_xor_si256 (Hash256 (_mm256_add_epi32 (counter, k0)), k1));
+
+      __m256 r = _mm256_sqrt_ps (_mm256_mul_ps (_mm256_set1_ps (-2.f), Log256 (Uniform256 (h0))));
+      __m256 b = _mm256_mul_ps (_mm256_sub_ps (Uniform256 (h1), _mm256_set1_ps (0.5f)), _mm256_set1_ps (g_halfPi));
+      __m256 z = _mm256_mul_ps (b, b);
+      __m256 s = _mm256_setzero_ps ();
+      __m256 c = _mm256_setzero_ps ();
+      for (uint32_t j = 0; j < g_sinNCoefficients; j++)
+        {
+          s = _mm256_add_ps (_mm256_mul_ps (s, z), _mm256_set1_ps (g_sinCoefficients[j]));
+        }
+      s = _mm256_mul_ps (s, b);
+      for (uint32_t j = 0; j < g_cosNCoefficients; j++)
+        {
+          c = _mm256_add_ps (_mm256_mul_ps (c, z), _mm256_set1_ps (g_cosCoefficients[j]));
+        }
+
+      // rotation by a quarter turn for bit 0, by a half turn for bit 1
+      __m256 quarter = _mm256_castsi256_ps (_mm256_cmpeq_epi32 (_mm256_and_si256 (h1, _mm256_set1_epi32 (1)),
+                                                                _mm256_set1_epi32 (1)));
+      __m256 half = _mm256_castsi256_ps (_mm256_cmpeq_epi32 (_mm256_and_si256 (h1, _mm256_set1_epi32 (2)),
+                                                             _mm256_set1_epi32 (2)));
+      __m256 sign = _mm256_and_ps (half, _mm256_set1_ps (-0.f));
+      __m256 rc = _mm256_blendv_ps (c, _mm256_xor_ps (s, _mm256_set1_ps (-0.f)), quarter);
+      __m256 rs = _mm256_blendv_ps (s, c, quarter);
+      _mm256_storeu_ps (normals + p, _mm256_mul_ps (r, _mm256_xor_ps (rc, sign)));
+      _mm256_storeu_ps (normals + p + g_nPairs, _mm256_mul_ps (r, _mm256_xor_ps (rs, sign)));
+    }
+}
+#elif defined (__SSE2__)
+inline __m128i
+Multiply128 (__m128i a, __m128i b)
+{
+  // the low 32 bits of the products, without the SSE4.1 _mm_mullo_epi32
+  __m128i even = _mm_mul_epu32 (a, b);
+  __m128i odd = _mm_mul_epu32 (_mm_srli_epi64 (a, 32), _mm_srli_epi64 (b, 32));
+  return _mm_unpacklo_epi32 (_mm_shuffle_epi32 (even, _MM_SHUFFLE (0, 0, 2, 0)),
+                             _mm_shuffle_epi32 (odd, _MM_SHUFFLE (0, 0, 2, 0)));
+}
+
+inline __m128i
+Hash128 (__m128i x)
+{
+  x = _mm_xor_si128 (x, _mm_srli_epi32 (x, 16));
+  x = Multiply128 (x, _mm_set1_epi32 (static_cast<int32_t> (g_hashMultiplier0)));
+  x = _mm_xor_si128 (x, _mm_srli_epi32 (x, 15));
+  x = Multiply128 (x, _mm_set1_epi32 (static_cast<int32_t> (g_hashMultiplier1)));
+  return _mm_xor_si128 (x, _mm_srli_epi32 (x, 16));
+}
+
+inline __m128
+Uniform128 (__m128i h)
+{
+  __m128 u = _mm_cvtepi32_ps (_mm_srli_epi32 (h, 8));
+  return _mm_mul_ps (_mm_add_ps (u, _mm_set1_ps (0.5f)), _mm_set1_ps (g_uniformScale));
+}
+
+inline __m128
+Select128 (__m128 mask, __m128 a, __m128 b)
+{
+  return _mm_or_ps (_mm_and_ps (mask, a), _mm_andnot_ps (mask, b));
+}
+
+inline __m128
+Log128 (__m128 u)
+{
+  __m128i bits = _mm_castps_si128 (u);
+  __m128 e = _mm_cvtepi32_ps (_mm_sub_epi32 (_mm_srli_epi32 (bits, 23), _mm_set1_epi32 (127)));
+  __m128 m = _mm_castsi128_ps (_mm_or_si128 (_mm_and_si128 (bits, _mm_set1_epi32 (0x007fffff)),
+                                             _mm_set1_epi32 (0x3f800000)));
+  __m128 large = _mm_cmpgt_ps (m, _mm_set1_ps (g_sqrt2));
+  m = Select128 (large, _mm_mul_ps (m, _mm_set1_ps (0.5f)), m);
+  e = _mm_add_ps (e, _mm_and_ps (large, _mm_set1_ps (1.f)));
+  __m128 s = _mm_div_ps (_mm_sub_ps (m, _mm_set1_ps (1.f)), _mm_add_ps (m, _mm_set1_ps (1.f)));
+  __m128 z = _mm_mul_ps (s, s);
+  __m128 p = _mm_setzero_ps ();
+  for (uint32_t j = 0; j < g_logNCoefficients; j++)
+    {
+      p = _mm_add_ps (_mm_mul_ps (p, z), _mm_set1_ps (g_logCoefficients[j]));
+    }
+  return _mm_add_ps (_mm_mul_ps (e, _mm_set1_ps (g_ln2)), _mm_mul_ps (s, p));
+}
+
+void
+Normals128 (uint32_t key0, uint32_t key1, float *normals)
+{
+  const __m128i lanes = _mm_setr_epi32 (0, 2, 4, 6);
+  const __m128i k0 = _mm_set1_epi32 (static_cast<int32_t> (key0));
+  const __m128i k1 = _mm_set1_epi32 (static_cast<int32_t> (key1));
+  for (uint32_t p = 0; p < g_nPairs; p += 4)
+    {
+      __m128i counter = _mm_add_epi32 (_mm_set1_epi32 (static_cast<int32_t> (2 * p)), lanes);
+      __m128i h0 = Hash128 (_mm_xor_si128 (Hash128 (_mm_add_epi32 (counter, k0)), k1));
+      counter = _mm_add_epi32 (counter, _mm_set1_epi32 (1));
+      __m128i h1 = Hash128 (_mm_xor_si128 (Hash128 (_mm_add_epi32 (counter, k0)), k1));
+
+      __m128 r = _mm_sqrt_ps (_mm_mul_ps (_mm_set1_ps (-2.f), Log128 (Uniform128 (h0))));
+      __m128 b = _mm_mul_ps (_mm_sub_ps (Uniform128 (h1), _mm_set1_ps (0.5f)), _mm_set1_ps (g_halfPi));
+      __m128 z = _mm_mul_ps (b, b);
+      __m128 s = _mm_setzero_ps ();
+      __m128 c = _mm_setzero_ps ();
+      for (uint32_t j = 0; j < g_sinNCoefficients; j++)
+        {
+          s = _mm_add_ps (_mm_mul_ps (s, z), _mm_set1_ps (g_sinCoefficients[j]));
+        }
+      s = _mm_mul_ps (s, b);
+      for (uint32_t j = 0; j < g_cosNCoefficients; j++)
+        {
+          c = _mm_add_ps (_mm_mul_ps (c, z), _mm_set1_ps (g_cosCoefficients[j]));
+        }
+
+      // rotation by a quarter turn for bit 0, by a half turn for bit 1
+      __m128 quarter = _mm_castsi128_ps (_mm_cmpeq_epi32 (_mm_and_si128 (h1, _mm_set1_epi32 (1)),
+                                                          _mm_set1_epi32 (1)));
+      __m128 half = _mm_castsi128_ps (_mm_cmpeq_epi32 (_mm_and_si128 (h1, _mm_set1_epi32 (2)),
+                                                       _mm_set1_epi32 (2)));
+      __m128 sign = _mm_and_ps (half, _mm_set1_ps (-0.f));
+      __m128 rc = Select128 (quarter, _mm_xor_ps (s, _mm_set1_ps (-0.f)), c);
+      __m128 rs = Select128 (quarter, c, s);
+      _mm_storeu_ps (normals + p, _mm_mul_ps (r, _mm_xor_ps (rc, sign)));
+      _mm_storeu_ps (normals + p + g_nPairs, _mm_mul_ps (r, _mm_xor_ps (rs, sign)));
+    }
+}
+#endif
+
+/*
+ * the 3 * g_blockSize deviates of a block: the cosines of the pairs fill
+ * the first half of normals, their sines the second one
+ */
+void
+Normals (uint32_t key0, uint32_t key1, float *normals)
+{
+#if defined (__AVX2__)
+  Normals256 (key0, key1, normals);
+#elif defined (__SSE2__)
+  Normals128 (key0, key1, normals);
+#else
+  NormalsScalar (key0, key1, normals);
+#endif
+}
+
+} // namespace
+
+P1906MOLParticles::P1906MOLParticles ()
+  : m_seed (1),
+    m_nReleases (0),
+    m_nSteps (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+P1906MOLParticles::~P1906MOLParticles ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+P1906MOLParticles::SetNThreads (uint32_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+  m_workerPool.SetNThreads (n);
+}
+
+uint32_t
+P1906MOLParticles::GetNThreads (void) const
+{
+  return m_workerPool.GetNThreads ();
+}
+
+void
+P1906MOLParticles::SetSeed (uint64_t seed)
+{
+  NS_LOG_FUNCTION (this << seed);
+  m_seed = seed;
+}
+
+uint64_t
+P1906MOLParticles::GetSeed (void) const
+{
+  return m_seed;
+}
+
+void
+P1906MOLParticles::Release (uint32_t n, const Vector &position)
+{
+  NS_LOG_FUNCTION (this << n);
+  // assign keeps the capacity of the previous releases
+  m_x.assign (n, 0.f);
+  m_y.assign (n, 0.f);
+  m_z.assign (n, 0.f);
+  m_origin = position;
+  m_nReleases++;
+  m_nSteps = 0;
+}
+
+void
+P1906MOLParticles::Step (double diffusion, double dt, const P1906MOLFlowGrid *flow)
+{
+  NS_LOG_FUNCTION (this << diffusion << dt << flow);
+  uint32_t nBlocks = (GetN () + g_blockSize - 1) / g_blockSize;
+  float sigma = std::sqrt (2. * diffusion * dt);
+  // the keys of the blocks of a step derive from the seed and the release
+  uint64_t key = SplitMix64 (SplitMix64 (m_seed ^ SplitMix64 (m_nReleases)) ^ SplitMix64 (m_nSteps));
+  m_nSteps++;
+
+  P1906MOLParticles *particles = this;
+  float step = dt;
+  m_workerPool.Run (nBlocks, [particles, sigma, key, step, flow] (uint32_t begin, uint32_t end)
+    {
+      for (uint32_t block = begin; block < end; block++)
+        {
+          if (flow)
+            {
+              particles->DriftBlock (block, step, flow);
+            }
+          uint64_t blockKey = SplitMix64 (key + block);
+          particles->StepBlock (block, sigma, static_cast<uint32_t> (blockKey), static_cast<uint32_t> (blockKey >> 32));
+        }
+    });
+}
+
+void
+P1906MOLParticles::StepBlock (uint32_t block, float sigma, uint32_t key0, uint32_t key1)
+{
+  float normals[3 * g_blockSize];
+  Normals (key0, key1, normals);
+
+  uint32_t begin = block * g_blockSize;
+  uint32_t n = std::min (g_blockSize, GetN () - begin);
+  float *x = &m_x[begin];
+  float *y = &m_y[begin];
+  float *z = &m_z[begin];
+  for (uint32_t i = 0; i < n; i++)
+    {
+      x[i] += sigma * normals[i];
+      y[i] += sigma * normals[i + g_blockSize];
+      z[i] += sigma * normals[i + 2 * g_blockSize];
+    }
+}
+
+void
+P1906MOLParticles::DriftBlock (uint32_t block, float dt, const P1906MOLFlowGrid *flow)
+{
+  float velocities[3 * g_blockSize];
+  uint32_t begin = block * g_blockSize;
+  uint32_t n = std::min (g_blockSize, GetN () - begin);
+  float *x = &m_x[begin];
+  float *y = &m_y[begin];
+  float *z = &m_z[begin];
+  float *vx = velocities;
+  float *vy = velocities + g_blockSize;
+  float *vz = velocities + 2 * g_blockSize;
+  // the velocities of the whole block first, then an explicit Euler step
+  flow->Interpolate (m_origin, x, y, z, n, vx, vy, vz);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      x[i] += dt * vx[i];
+      y[i] += dt * vy[i];
+      z[i] += dt * vz[i];
+    }
+}
+
+uint32_t
+P1906MOLParticles::GetN (void) const
+{
+  return m_x.size ();
+}
+
+uint32_t
+P1906MOLParticles::GetNSteps (void) const
+{
+  return m_nSteps;
+}
+
+uint64_t
+P1906MOLParticles::GetNReleases (void) const
+{
+  return m_nReleases;
+}
+
+Vector
+P1906MOLParticles::GetOrigin (void) const
+{
+  return m_origin;
+}
+
+const float*
+P1906MOLParticles::GetX (void) const
+{
+  return m_x.empty () ? 0 : &m_x[0];
+}
+
+const float*
+P1906MOLParticles::GetY (void) const
+{
+  return m_y.empty () ? 0 : &m_y[0];
+}
+
+const float*
+P1906MOLParticles::GetZ (void) const
+{
+  return m_z.empty () ? 0 : &m_z[0];
+}
+
+uint32_t
+P1906MOLParticles::GetNChunks (void) const
+{
+  return m_workerPool.GetNThreads ();
+}
+
+void
+P1906MOLParticles::Visit (const Visitor &visit)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t n = GetN ();
+  uint32_t nBlocks = (n + g_blockSize - 1) / g_blockSize;
+  if (nBlocks == 0)
+    {
+      return;
+    }
+
+  std::vector<uint32_t> kept (nBlocks);
+  uint32_t nChunks = GetNChunks ();
+  m_workerPool.Run (nChunks, [this, &visit, &kept, n, nBlocks, nChunks] (uint32_t begin, uint32_t end)
+    {
+      for (uint32_t chunk = begin; chunk < end; chunk++)
+        {
+          uint32_t last = static_cast<uint64_t> (nBlocks) * (chunk + 1) / nChunks;
+          for (uint32_t block = static_cast<uint64_t> (nBlocks) * chunk / nChunks; block < last; block++)
+            {
+              uint32_t first = block * g_blockSize;
+              kept[block] = visit (chunk, &m_x[first], &m_y[first], &m_z[first], std::min (g_blockSize, n - first));
+            }
+        }
+    });
+
+  // the kept molecules are at the front of their blocks
+  uint32_t packed = 0;
+  for (uint32_t block = 0; block < nBlocks; block++)
+    {
+      uint32_t first = block * g_blockSize;
+      if (packed != first)
+        {
+          std::copy (m_x.begin () + first, m_x.begin () + first + kept[block], m_x.begin () + packed);
+          std::copy (m_y.begin () + first, m_y.begin () + first + kept[block], m_y.begin () + packed);
+          std::copy (m_z.begin () + first, m_z.begin () + first + kept[block], m_z.begin () + packed);
+        }
+      packed += kept[block];
+    }
+  m_x.resize (packed);
+  m_y.resize (packed);
+  m_z.resize (packed);
+}
+
+} // namespace ns3
@@ -0,0 +1,166 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+#ifndef P1906_MOL_PARTICLES
+#define P1906_MOL_PARTICLES
+
+#include <stdint.h>
+#include <vector>
+#include <functional>
+#include "ns3/vector.h"
+#include "ns3/p1906-worker-pool.h"
+#include "ns3/p1906-mol-flow-grid.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup P1906 framework
+ *
+ * \class P1906MOLParticles
+ *
+ * \brief Brownian motion of the molecules of a release, used by the
+ * particle mode of P1906MOLMotion.
+ *
+ * The molecules are stored as a structure of arrays: three arrays of
+ * single precision offsets [m] from the release position, i.e., 12 bytes
+ * per molecule and no object per molecule, so that a release of 1e8
+ * molecules takes 1.2 GB. Offsets keep the precision of float far from the
+ * origin of the scenario, since they stay within a few diffusion lengths.
+ *
+ * Step draws one Gaussian displacement per molecule and axis. The normal
+ * deviates come from a counter-based generator, i.e., a hash of the seed,
+ * of the release, of the step and of the index of the deviate, so that
+ * each release follows its own trajectories, turned into pairs of normal
+ * deviates by the Box-Muller transform with polynomial logarithm, sine and
+ * cosine. The transform uses AVX2 when the module is compiled with it
+ * enabled, SSE2 on any other x86-64 build, and a scalar loop elsewhere.
+ * The molecules are split in blocks processed concurrently by a worker
+ * pool, and the deviates of a molecule do not depend on its block or on
+ * the number of threads, so the trajectories are reproducible.
+ *
+ * In a flowing medium, Step also moves each molecule by the velocity of
+ * the flow at its position times the time step, interpolated in blocks by
+ * P1906MOLFlowGrid::Interpolate.
+ */
+
+class P1906MOLParticles
+{
+public:
+  /**
+   * \brief called by Visit on the n molecules of a block, whose offsets are
+   * x, y and z, from the thread processing chunk. It returns the number of
+   * molecules it keeps, moved to the front of the block, and the others are
+   * removed.
+   */
+  typedef std::function<uint32_t (uint32_t chunk, float *x, float *y, float *z, uint32_t n)> Visitor;
+
+  P1906MOLParticles ();
+  ~P1906MOLParticles ();
+
+  /**
+   * \param n the number of threads advancing the molecules, including the
+   * calling one; 0 and 1 run on the calling thread
+   */
+  void SetNThreads (uint32_t n);
+  uint32_t GetNThreads (void) const;
+  /**
+   * \brief sets the seed of the displacements of the next releases
+   */
+  void SetSeed (uint64_t seed);
+  uint64_t GetSeed (void) const;
+
+  /**
+   * \brief replaces the molecules by n molecules at position
+   */
+  void Release (uint32_t n, const Vector &position);
+  /**
+   * \brief advances every molecule by a displacement of variance
+   * 2 * diffusion * dt along each axis, plus the drift of the flow
+   * \param diffusion the diffusion coefficient [m^2/s]
+   * \param dt the time step [s]
+   * \param flow the velocity of the medium at the beginning of the step, or
+   * 0 for a still medium
+   */
+  void Step (double diffusion, double dt, const P1906MOLFlowGrid *flow = 0);
+
+  /**
+   * \returns the number of molecules
+   */
+  uint32_t GetN (void) const;
+  /**
+   * \returns the number of steps since the last release
+   */
+  uint32_t GetNSteps (void) const;
+  /**
+   * \returns the number of releases since the creation of the particles;
+   * SetSeed does not reset it
+   */
+  uint64_t GetNReleases (void) const;
+  /**
+   * \returns the position of the last release, from which the offsets are
+   * measured
+   */
+  Vector GetOrigin (void) const;
+  /**
+   * \returns the GetN () offsets [m] of the molecules along x, y and z
+   */
+  const float* GetX (void) const;
+  const float* GetY (void) const;
+  const float* GetZ (void) const;
+
+  /**
+   * \returns the number of chunks of Visit, i.e., the number of threads
+   */
+  uint32_t GetNChunks (void) const;
+  /**
+   * \brief calls visit on every block of molecules, in GetNChunks ()
+   * concurrent chunks of consecutive blocks, then packs the molecules the
+   * calls kept
+   */
+  void Visit (const Visitor &visit);
+
+private:
+  P1906MOLParticles (const P1906MOLParticles &);
+  P1906MOLParticles &operator= (const P1906MOLParticles &);
+
+  void StepBlock (uint32_t block, float sigma, uint32_t key0, uint32_t key1);
+  void DriftBlock (uint32_t block, float dt, const P1906MOLFlowGrid *flow);
+
+  std::vector<float> m_x;
+  std::vector<float> m_y;
+  std::vector<float> m_z;
+  Vector m_origin;
+  uint64_t m_seed;
+  uint64_t m_nReleases;
+  uint32_t m_nSteps;
+  P1906WorkerPool m_workerPool;
+};
+
+}
+
+#endif /* P1906_MOL_PARTICLES */
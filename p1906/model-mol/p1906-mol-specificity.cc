@@ -28,6 +28,7 @@
 
 
 #include "ns3/log.h"
+#include "ns3/simulator.h"
 
 #include "p1906-mol-specificity.h"
 #include "ns3/p1906-specificity.h"
@@ -37,6 +38,7 @@
 #include "ns3/p1906-receiver-communication-interface.h"
 #include "ns3/p1906-transmitter-communication-interface.h"
 #include "p1906-mol-perturbation.h"
+#include "p1906-mol-field.h"
 #include "ns3/mobility-model.h"
 
 
@@ -52,6 +54,13 @@ TypeId P1906MOLSpecificity::GetTypeId (void)
 }
 
 P1906MOLSpecificity::P1906MOLSpecificity ()
+  : m_counting (false),
+    m_receiverRadius (0),
+    m_absorbing (false),
+    m_detectionThreshold (1),
+    m_isiEpsilon (0),
+    m_isiRatio (1),
+    m_residualConcentration (0)
 {
   NS_LOG_FUNCTION (this << "MOL Specificity Component");
 }
@@ -89,6 +98,25 @@ P1906MOLSpecificity::CheckRxCompatibility (Ptr<P1906CommunicationInterface> src,
 
   NS_LOG_FUNCTION (this << "testcapacity: [distance, txRate, channelCapacity]" << distance << transmissionRate << channelCapacity);
 
+  if (m_counting)
+    {
+      m_arrivalBinWidth = m->GetArrivalBinWidth ();
+      m_arrivals = m->GetArrivals ();
+    }
+
+  // before any decision, so that the window holds every release
+  if (m_isiEpsilon > 0 && !CheckInterference (m, src, srcMobility->GetPosition (), dstMobility->GetPosition ()))
+    {
+      NS_LOG_FUNCTION (this << "inter-symbol interference too large --> transmission failed" << m_residualConcentration);
+      return false;
+    }
+
+  if (m_counting && m->GetMolecules () < m_detectionThreshold)
+    {
+      NS_LOG_FUNCTION (this << "too few molecules counted --> transmission failed" << m->GetMolecules ());
+      return false;
+    }
+
   if (channelCapacity >= transmissionRate)
 	{
 	  NS_LOG_FUNCTION (this << "Fick's bound has been respected");
@@ -101,6 +129,89 @@ P1906MOLSpecificity::CheckRxCompatibility (Ptr<P1906CommunicationInterface> src,
 	}
 }
 
+double
+P1906MOLSpecificity::GetConcentration (const Release &release, double t) const
+{
+  if (t <= 0)
+    {
+      return 0;
+    }
+  return release.m_molecules * P1906MOLField::GetConcentration (m_diffusionCoefficient, release.m_displacement,
+                                                                release.m_velocity, t);
+}
+
+bool
+P1906MOLSpecificity::CheckInterference (Ptr<P1906MOLMessageCarrier> m, Ptr<P1906CommunicationInterface> src,
+                                        const Vector &srcPosition, const Vector &dstPosition)
+{
+  NS_LOG_FUNCTION (this << m_isiWindow.size ());
+  Time now = Simulator::Now ();
+
+  // the residual of the window, evaluated again at each check and pruned in
+  // the same pass
+  double residual = 0;
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < m_isiWindow.size (); i++)
+    {
+      const Release &release = m_isiWindow[i];
+      double t = (now - release.m_start).GetSeconds ();
+      double concentration = GetConcentration (release, t);
+      // past its peak, the concentration of a release only decreases
+      if (t > release.m_peakTime && concentration < m_isiEpsilon * release.m_peakConcentration)
+        {
+          continue;
+        }
+      residual += concentration;
+      m_isiWindow[kept++] = release;
+    }
+  m_isiWindow.resize (kept);
+
+  Release release;
+  release.m_start = m->GetStartTime ();
+  release.m_molecules = m->GetReleasedMolecules ();
+  release.m_displacement = Vector (dstPosition.x - srcPosition.x, dstPosition.y - srcPosition.y,
+                                   dstPosition.z - srcPosition.z);
+  // the drift of the flow P1906MOLMotion applies to the carrier, if any
+  release.m_velocity = Vector (0, 0, 0);
+  Ptr<P1906Field> field = src->GetP1906TransmitterCommunicationInterface ()->GetP1906Field ();
+  if (field && !field->IsEmpty ())
+    {
+      Ptr<P1906MOLField> flow = field->GetObject<P1906MOLField> ();
+      if (flow)
+        {
+          release.m_velocity = flow->GetMeanVelocity (srcPosition, dstPosition);
+        }
+    }
+  release.m_peakTime = P1906MOLField::GetPeakTime (m_diffusionCoefficient, CalculateDistance (srcPosition, dstPosition),
+                                                   release.m_velocity);
+  release.m_peakConcentration = GetConcentration (release, release.m_peakTime);
+  m_isiWindow.push_back (release);
+
+  double signal = GetConcentration (release, (now - release.m_start).GetSeconds ());
+  m_residualConcentration = residual;
+
+  NS_LOG_FUNCTION (this << "[signal,residual,window]" << signal << residual << m_isiWindow.size ());
+  return signal >= m_isiRatio * residual;
+}
+
+double
+P1906MOLSpecificity::GetMaxRange (Ptr<P1906Perturbation> perturbation)
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<P1906MOLPerturbation> p = perturbation->GetObject<P1906MOLPerturbation> ();
+  if (!p)
+    {
+      return P1906Specificity::GetMaxRange (perturbation);
+    }
+
+  double transmissionRate = 1. / p->GetPulseInterval ().GetSeconds ();
+  // widened by 1e-9 so that rounding never excludes a distance the bound accepts
+  double maxRange = sqrt (GetDiffusionConefficient () / (0.4501 * transmissionRate)) * (1. + 1e-9);
+
+  NS_LOG_FUNCTION (this << "[txRate,maxRange]" << transmissionRate << maxRange);
+  return maxRange;
+}
+
 void
 P1906MOLSpecificity::SetDiffusionCoefficient (double d)
 {
@@ -115,4 +226,92 @@ P1906MOLSpecificity::GetDiffusionConefficient (void)
   return m_diffusionCoefficient;
 }
 
+void
+P1906MOLSpecificity::SetCountingReceiver (double radius, bool absorbing)
+{
+  NS_LOG_FUNCTION (this << radius << absorbing);
+  m_counting = true;
+  m_receiverRadius = radius;
+  m_absorbing = absorbing;
+}
+
+bool
+P1906MOLSpecificity::IsCountingReceiver (void) const
+{
+  return m_counting;
+}
+
+double
+P1906MOLSpecificity::GetReceiverRadius (void) const
+{
+  return m_receiverRadius;
+}
+
+bool
+P1906MOLSpecificity::IsAbsorbing (void) const
+{
+  return m_absorbing;
+}
+
+void
+P1906MOLSpecificity::SetDetectionThreshold (double threshold)
+{
+  NS_LOG_FUNCTION (this << threshold);
+  m_detectionThreshold = threshold;
+}
+
+double
+P1906MOLSpecificity::GetDetectionThreshold (void) const
+{
+  return m_detectionThreshold;
+}
+
+const std::vector<uint32_t>&
+P1906MOLSpecificity::GetArrivals (void) const
+{
+  return m_arrivals;
+}
+
+Time
+P1906MOLSpecificity::GetArrivalBinWidth (void) const
+{
+  return m_arrivalBinWidth;
+}
+
+void
+P1906MOLSpecificity::SetIsiTracking (double epsilon, double ratio)
+{
+  NS_LOG_FUNCTION (this << epsilon << ratio);
+  m_isiEpsilon = epsilon;
+  m_isiRatio = ratio;
+  if (epsilon <= 0)
+    {
+      m_isiWindow.clear ();
+    }
+}
+
+double
+P1906MOLSpecificity::GetIsiEpsilon (void) const
+{
+  return m_isiEpsilon;
+}
+
+double
+P1906MOLSpecificity::GetIsiRatio (void) const
+{
+  return m_isiRatio;
+}
+
+uint32_t
+P1906MOLSpecificity::GetIsiWindowSize (void) const
+{
+  return m_isiWindow.size ();
+}
+
+double
+P1906MOLSpecificity::GetResidualConcentration (void) const
+{
+  return m_residualConcentration;
+}
+
 } // namespace ns3
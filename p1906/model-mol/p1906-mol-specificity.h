@@ -33,10 +33,14 @@
 #include "ns3/object.h"
 #include "ns3/nstime.h"
 #include "ns3/ptr.h"
+#include "ns3/vector.h"
 #include "ns3/p1906-specificity.h"
+#include <vector>
 
 namespace ns3 {
 
+class P1906MOLMessageCarrier;
+
 /**
  * \ingroup P1906 framework
  *
@@ -56,12 +60,105 @@ public:
 
   virtual bool CheckRxCompatibility (Ptr<P1906CommunicationInterface> src, Ptr<P1906CommunicationInterface> dst, Ptr<P1906MessageCarrier> message);
 
+  /**
+   * \brief the bound of CheckRxCompatibility solved for the distance,
+   * d_max = sqrt(D / (0.4501 * txRate))
+   */
+  virtual double GetMaxRange (Ptr<P1906Perturbation> perturbation);
+
   void SetDiffusionCoefficient (double d);
   double GetDiffusionConefficient (void);
 
+  /**
+   * \brief makes the receiver a counting receiver of the particle mode of
+   * P1906MOLMotion, i.e., a sphere of radius [m] around it, absorbing the
+   * molecules it counts or not (see P1906MOLCountingReceivers)
+   */
+  void SetCountingReceiver (double radius, bool absorbing);
+  bool IsCountingReceiver (void) const;
+  double GetReceiverRadius (void) const;
+  bool IsAbsorbing (void) const;
+  /**
+   * \param threshold the molecules a counting receiver needs to count to
+   * detect a carrier, besides respecting Fick's bound; 1 by default
+   */
+  void SetDetectionThreshold (double threshold);
+  double GetDetectionThreshold (void) const;
+  /**
+   * \returns the molecules counted per bin of GetArrivalBinWidth () for the
+   * last carrier checked by a counting receiver
+   */
+  const std::vector<uint32_t>& GetArrivals (void) const;
+  Time GetArrivalBinWidth (void) const;
+
+  /**
+   * \brief enables the tracking of the inter-symbol interference, disabled
+   * by default.
+   *
+   * The receiver keeps a window of the releases whose carriers it checked,
+   * and evaluates their expected concentration at each new carrier with the
+   * impulse response of Fick's law, N / (4 pi D t)^(3/2) e^(-|r - v t|^2 /
+   * (4 D t)), r being the displacement from the transmitter and v the mean
+   * velocity of the flow of its P1906MOLField between the two nodes, as in
+   * P1906MOLMotion (v = 0 in a still medium). The residual is evaluated
+   * again over the whole window at each check. A release leaves the window
+   * once past its peak and below epsilon times its peak concentration, so
+   * that a check costs O(window) whatever the number of releases before.
+   * As the tail decays as t^(-3/2) only, the pruned releases still add up,
+   * to about epsilon times the peak per release over the lifetime of a
+   * release in the window; epsilon should then shrink as the release rate
+   * grows. A carrier is then detected only if its own concentration is at
+   * least ratio times the residual concentration of the others. The
+   * releases are known from the reception of their carriers, i.e., the
+   * residual ignores the carriers still propagating.
+   *
+   * \param epsilon the relative concentration below which a release is
+   * pruned, or 0 to disable the tracking
+   * \param ratio the smallest ratio of the concentration of a carrier to
+   * the residual one
+   */
+  void SetIsiTracking (double epsilon, double ratio);
+  double GetIsiEpsilon (void) const;
+  double GetIsiRatio (void) const;
+  /**
+   * \returns the number of releases in the window
+   */
+  uint32_t GetIsiWindowSize (void) const;
+  /**
+   * \returns the residual concentration [molecules/m^3] of the other
+   * releases when the last carrier was checked
+   */
+  double GetResidualConcentration (void) const;
+
 private:
+  struct Release
+  {
+    Time m_start;
+    double m_molecules;
+    Vector m_displacement;        ///< [m] from the transmitter to the receiver
+    Vector m_velocity;            ///< [m/s] mean velocity of the flow between them
+    double m_peakTime;            ///< [s] after m_start
+    double m_peakConcentration;
+  };
+
+  double GetConcentration (const Release &release, double t) const;
+  bool CheckInterference (Ptr<P1906MOLMessageCarrier> m, Ptr<P1906CommunicationInterface> src,
+                          const Vector &srcPosition, const Vector &dstPosition);
+
   double m_diffusionCoefficient;
 
+  bool m_counting;
+  double m_receiverRadius;
+  bool m_absorbing;
+  double m_detectionThreshold;
+  Time m_arrivalBinWidth;
+  std::vector<uint32_t> m_arrivals;
+
+  double m_isiEpsilon;
+  double m_isiRatio;
+  std::vector<Release> m_isiWindow;
+  double m_residualConcentration;
+
 };
 
 }
@@ -0,0 +1,143 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *  Copyright � 2014 by IEEE.
+ *
+ *  This source file is an essential part of IEEE P1906.1,
+ *  Recommended Practice for Nanoscale and Molecular
+ *  Communication Framework.
+ *  Verbatim copies of this source file may be used and
+ *  distributed without restriction. Modifications to this source
+ *  file as permitted in IEEE P1906.1 may also be made and
+ *  distributed. All other uses require permission from the IEEE
+ *  Standards Department (stds-ipr@ieee.org). All other rights
+ *  reserved.
+ *
+ *  This source file is provided on an AS IS basis.
+ *  The IEEE disclaims ANY WARRANTY EXPRESS OR IMPLIED INCLUDING
+ *  ANY WARRANTY OF MERCHANTABILITY AND FITNESS FOR USE FOR A
+ *  PARTICULAR PURPOSE.
+ *  The user of the source file shall indemnify and hold
+ *  IEEE harmless from any damages or liability arising out of
+ *  the use thereof.
+ *
+ * Author: Giuseppe Piro - Telematics Lab Research Group
+ *                         Politecnico di Bari
+ *                         giuseppe.piro@poliba.it
+ *                         telematics.poliba.it/piro
+ */
+
+#include "ns3/test.h"
+#include "ns3/p1906-mol-particles.h"
+#include <vector>
+
+using namespace ns3;
+
+namespace {
+
+const uint32_t g_nMolecules = 10000;
+const uint32_t g_nSteps = 5;
+const double g_diffusion = 1e-9;
+const double g_dt = 1e-3;
+
+/*
+ * the offsets of the molecules of a release at the origin after g_nSteps
+ * steps, x then y then z
+ */
+std::vector<float>
+Simulate (P1906MOLParticles &particles)
+{
+  particles.Release (g_nMolecules, Vector (0, 0, 0));
+  for (uint32_t step = 0; step < g_nSteps; step++)
+    {
+      particles.Step (g_diffusion, g_dt);
+    }
+  std::vector<float> offsets (particles.GetX (), particles.GetX () + particles.GetN ());
+  offsets.insert (offsets.end (), particles.GetY (), particles.GetY () + particles.GetN ());
+  offsets.insert (offsets.end (), particles.GetZ (), particles.GetZ () + particles.GetN ());
+  return offsets;
+}
+
+}
+
+/**
+ * \brief two releases of the same particles follow distinct trajectories
+ */
+class P1906MOLParticlesReleaseTestCase : public TestCase
+{
+public:
+  P1906MOLParticlesReleaseTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+P1906MOLParticlesReleaseTestCase::P1906MOLParticlesReleaseTestCase ()
+  : TestCase ("Consecutive releases draw distinct displacements")
+{
+}
+
+void
+P1906MOLParticlesReleaseTestCase::DoRun (void)
+{
+  P1906MOLParticles particles;
+  particles.SetSeed (7);
+  std::vector<float> first = Simulate (particles);
+  std::vector<float> second = Simulate (particles);
+  NS_TEST_ASSERT_MSG_EQ (particles.GetNReleases (), 2, "every release is counted");
+
+  uint32_t nEqual = 0;
+  for (uint32_t i = 0; i < first.size (); i++)
+    {
+      nEqual += (first[i] == second[i]);
+    }
+  NS_TEST_ASSERT_MSG_LT (nEqual, first.size () / 100, "the two releases replayed the same trajectories");
+}
+
+/**
+ * \brief the trajectories depend on the seed and on the release only, not
+ * on the number of threads
+ */
+class P1906MOLParticlesReproducibleTestCase : public TestCase
+{
+public:
+  P1906MOLParticlesReproducibleTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+P1906MOLParticlesReproducibleTestCase::P1906MOLParticlesReproducibleTestCase ()
+  : TestCase ("Releases with the same seed are reproducible")
+{
+}
+
+void
+P1906MOLParticlesReproducibleTestCase::DoRun (void)
+{
+  P1906MOLParticles serial;
+  P1906MOLParticles concurrent;
+  serial.SetSeed (7);
+  concurrent.SetSeed (7);
+  concurrent.SetNThreads (4);
+  for (uint32_t release = 0; release < 2; release++)
+    {
+      std::vector<float> a = Simulate (serial);
+      std::vector<float> b = Simulate (concurrent);
+      NS_TEST_ASSERT_MSG_EQ ((a == b), true, "release " << release << " differs between the two particles");
+    }
+}
+
+class P1906MOLParticlesTestSuite : public TestSuite
+{
+public:
+  P1906MOLParticlesTestSuite ();
+};
+
+P1906MOLParticlesTestSuite::P1906MOLParticlesTestSuite ()
+  : TestSuite ("p1906-mol-particles", UNIT)
+{
+  AddTestCase (new P1906MOLParticlesReleaseTestCase, TestCase::QUICK);
+  AddTestCase (new P1906MOLParticlesReproducibleTestCase, TestCase::QUICK);
+}
+
+static P1906MOLParticlesTestSuite g_p1906MOLParticlesTestSuite;